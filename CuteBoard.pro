@@ -4,3 +4,6 @@ CONFIG += ordered
 SUBDIRS = \
     datasources \
     app 
+
+# test senders for the network data sources
+unix: SUBDIRS += tools
@@ -105,7 +105,11 @@ HEADERS += \
     ../dashboard/layouts/layout_grid.h \
     ../dashboard/layouts/layout_reactive.h \
     ../dashboard/dashboard_parameter.h \
+    ../data/data_archive.h \
+    ../data/data_archive_codec.h \
     ../data/data_buffer.h \
+    ../data/data_catalog.h \
+    ../data/data_common.h \
     ../project/alarm_configuration.h \
     ../project/bitfieldsmapping.h \
     ../project/colorsettings.h \
@@ -148,8 +152,15 @@ HEADERS += \
     ../data/data_source_interface.h \
     ../data/data_manager.h \
     ../data/data_sample.h \
+    ../data/data_sample_queue.h \
     ../data/data_serie.h \
+    ../data/data_serie_tiers.h \
+    ../data/data_snapshot.h \
+    ../data/data_timestamp.h \
     ../data/data_parameter.h \
+    ../data/data_replay.h \
+    ../data/data_resolver.h \
+    ../data/data_export.h \
     ../data/data_value.h \
     ../data/data_source.h \
     ../ui/util/propertiestablewidget.h \
@@ -183,8 +194,14 @@ SOURCES += \
     ../dashboard/dashboard.cpp \
     ../dashboard/layouts/layout_grid.cpp \
     ../dashboard/layouts/layout_reactive.cpp \
+    ../data/data_archive.cpp \
     ../data/data_buffer.cpp \
+    ../data/data_catalog.cpp \
     ../data/data_parameter.cpp \
+    ../data/data_replay.cpp \
+    ../data/data_resolver.cpp \
+    ../data/data_snapshot.cpp \
+    ../data/data_export.cpp \
     ../project/alarm_configuration.cpp \
     ../project/bitfieldsmapping.cpp \
     ../project/colorsettings.cpp \
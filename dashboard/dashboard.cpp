@@ -193,15 +193,21 @@ void QTBoard::update(QDateTime time)
 {
     mReferenceTime = std::move(time);
     emit timeUpdate(mReferenceTime);
+    if(mDataManager)
+        mLatestSamples = mDataManager->latestSamples();
+    const bool samplesChanged = markChangedElements();
 
     if(!mLoadingPage) {
         //        QElapsedTimer timer;
         //        timer.start();
 
+        if(mDataHistoryDirty)
+            updateDataHistory();
+
         if(mFullReplot) {
         replot();
             mFullReplot = false;
-        } else {
+        } else if(samplesChanged) {
             updateLayout();
             layer(QLatin1String("grid"))->replot();
             layer(QLatin1String("main"))->replot();
@@ -262,11 +268,23 @@ void QTBoard::loadHistoricalData()
     }
 }
 
+void QTBoard::reloadHistoricalData()
+{
+    for(int i=0; i< mDashboardLayout->elementCount();i++) {
+        if (auto *el = qobject_cast<QTBDashboardElement*>(mDashboardLayout->elementAt(i))) {
+            el->clearSamples();
+            el->processHistoricalSamples();
+        }
+    }
+    mFullReplot = true;
+}
+
 void QTBoard::initDataManager()
 {
     mDataManager = QSharedPointer<QTBDataManager>(new QTBDataManager());
-    connect(mDataManager.data(), &QTBDataManager::parametersUpdated, this, &QTBoard::checkParameters);
+    mLatestSamples = mDataManager->latestSamples();
     connect(mDataManager.data(), &QTBDataManager::dataUpdated, this, &QTBoard::update);
+    connect(mDataManager.data(), &QTBDataManager::dataReset, this, &QTBoard::reloadHistoricalData);
     connect(mDataManager.data(), SIGNAL(updateDashboard()),
             this, SLOT(replot()));
 }
@@ -419,9 +437,62 @@ void QTBoard::setLiveDataRefreshEnabled(bool liveDataRefreshEnabled)
     }
 }
 
+void QTBoard::subscribeSamples(QTBDashboardElement *element, quint32 parameterId)
+{
+    QVector<QTBDashboardElement *> &subscribers = mSampleSubscribers[parameterId];
+    if(!subscribers.contains(element)) {
+        subscribers.append(element);
+        mSubscribedSamples[element].append(parameterId);
+    }
+}
+
+void QTBoard::unsubscribeSamples(QTBDashboardElement *element)
+{
+    for(quint32 parameterId : mSubscribedSamples.take(element)) {
+        QHash<quint32, QVector<QTBDashboardElement *>>::iterator it = mSampleSubscribers.find(parameterId);
+        if(it != mSampleSubscribers.end()) {
+            it.value().removeOne(element);
+            if(it.value().isEmpty())
+                mSampleSubscribers.erase(it);
+        }
+    }
+}
+
+bool QTBoard::markChangedElements()
+{
+    // only the subscribers of the series changed since the previous frame
+    // refresh; when that can't be told, all of them do
+    if(mLatestSamples) {
+        QVector<quint32> changed;
+        if(mLatestSamples->changedSince(mLatestTick, changed)) {
+            for(quint32 parameterId : changed) {
+                QHash<quint32, QVector<QTBDashboardElement *>>::const_iterator it = mSampleSubscribers.constFind(parameterId);
+                if(it != mSampleSubscribers.constEnd()) {
+                    for(QTBDashboardElement *element : it.value())
+                        element->samplesChanged();
+                }
+            }
+        } else {
+            QHash<QTBDashboardElement *, QVector<quint32>>::const_iterator it;
+            for(it = mSubscribedSamples.constBegin(); it != mSubscribedSamples.constEnd(); ++it)
+                it.key()->samplesChanged();
+        }
+        mLatestTick = mLatestSamples->tick();
+    }
+
+    bool replotNeeded = false;
+    for(int i=0; i< mDashboardLayout->elementCount();i++) {
+        if (auto *el = qobject_cast<QTBDashboardElement*>(mDashboardLayout->elementAt(i))) {
+            if(el->needsReplot())
+                replotNeeded = true;
+        }
+    }
+    return replotNeeded;
+}
+
 double QTBoard::currentTimestamp()
 {
-    return mReferenceTime.time().msecsSinceStartOfDay() / 1000.0;
+    return mReferenceTime.toMSecsSinceEpoch() / 1000.0;
 }
 
 void QTBoard::clearPage()
@@ -464,6 +535,7 @@ void QTBoard::loadPage()
         mProject->setCurrentPageName(page->name());
 
         loadHistoricalData();
+        mDataHistoryDirty = true;
 
         mLoadingPage = false;
 
@@ -480,13 +552,37 @@ void QTBoard::savePage()
     }
 }
 
-void QTBoard::checkParameters()
+void QTBoard::updateDataHistory()
 {
+    mDataHistoryDirty = false;
+    if(!mDataManager)
+        return;
+
+    // widest history displayed for each parameter of the page
+    QHash<quint32, double> history;
     for(int i=0; i< mDashboardLayout->elementCount();i++) {
         if (auto *el = qobject_cast<QTBDashboardElement*>(mDashboardLayout->elementAt(i))) {
-            el->checkParameters();
+            double duration = el->requiredHistory();
+            if(duration > 0) {
+                for(int j=0; j< el->parametersCount();j++) {
+                    quint32 parameterId = el->dashParameter(j)->getParameterId();
+                    if(parameterId > 0 && duration > history.value(parameterId, 0))
+                        history.insert(parameterId, duration);
+                }
+            }
         }
     }
+
+    QHash<quint32, double>::const_iterator it;
+    for (it = mDataHistory.constBegin(); it != mDataHistory.constEnd(); ++it) {
+        if(!history.contains(it.key()))
+            mDataManager->setHistory(it.key(), 0);
+    }
+    for (it = history.constBegin(); it != history.constEnd(); ++it) {
+        if(mDataHistory.value(it.key(), 0) != it.value())
+            mDataManager->setHistory(it.key(), it.value());
+    }
+    mDataHistory = history;
 }
 
 QSharedPointer<QTBProject> QTBoard::project() const
@@ -7,6 +7,7 @@
 class QTBProject;
 class QTBLayoutReactive;
 class QTBLayoutReactiveElement;
+class QTBDashboardElement;
 class QTBoard : public QCustomPlot
 {
     Q_OBJECT
@@ -41,6 +42,14 @@ public:
 
     double currentTimestamp();
 
+    void dataHistoryChanged() { mDataHistoryDirty = true; }
+    // latest samples taken at the start of the frame
+    const QTBDataSnapshotTable *latestSamples() const { return mLatestSamples; }
+    // the element is told when a sample of the parameter changed
+    void subscribeSamples(QTBDashboardElement *element, quint32 parameterId);
+    void unsubscribeSamples(QTBDashboardElement *element);
+    void updateDataHistory();
+
     QColor backColor() const;
     QColor frontColor() const;
     QColor randomColor();
@@ -54,8 +63,8 @@ public slots:
     void clearPage();
     void loadPage();
     void savePage();
-    void checkParameters();
     void update(QDateTime time);
+    void reloadHistoricalData();
 
 protected:
     QFont mFontLight;
@@ -77,6 +86,7 @@ protected:
     void dragLeaveEvent(QDragLeaveEvent *event) Q_DECL_OVERRIDE;
 
     void initStyle();
+    bool markChangedElements();
 
     QDateTime mReferenceTime;
 
@@ -84,6 +94,12 @@ protected:
     bool mPageModified{false};
     bool mLiveDataRefreshEnabled{true};
     bool mFullReplot{true};
+    bool mDataHistoryDirty{true};
+    QHash<quint32, double> mDataHistory;
+    const QTBDataSnapshotTable *mLatestSamples{nullptr};
+    quint64 mLatestTick{0};
+    QHash<quint32, QVector<QTBDashboardElement *>> mSampleSubscribers;
+    QHash<QTBDashboardElement *, QVector<quint32>> mSubscribedSamples;
 
     double mReplotTime;
     bool mFirstReplot;
@@ -10,6 +10,14 @@ QTBDashboardElement::QTBDashboardElement(QTBoard *dashboard):
 
 }
 
+QTBDashboardElement::~QTBDashboardElement()
+{
+    if(mResolver)
+        mResolver->unsubscribe(this);
+    if(mBoard)
+        mBoard->unsubscribeSamples(this);
+}
+
 QSharedPointer<QTBDashboardParameter> QTBDashboardElement::addParameter(QExplicitlySharedDataPointer<QTBParameterConfiguration> parameterSettings)
 {
     QSharedPointer<QTBDashboardParameter> dashParam;
@@ -60,12 +68,14 @@ void QTBDashboardElement::addParameter(QSharedPointer<QTBDashboardParameter> das
     } else if (mDashParameters.count() == mParametersMaxCount) {
         QSharedPointer<QTBDashboardParameter> toRemove = mDashParameters.takeLast();
         mParametersLabel.removeAll(toRemove->getLabel());
+        unbindParameter(toRemove->getLabel());
         mDashParameters.append(dashParameter);
         mParametersLabel.append(dashParameter->getLabel());
     }
 
-    checkParameters();
+    rebindParameters();
     updateElement();
+    mBoard->dataHistoryChanged();
 }
 
 void QTBDashboardElement::updateDashboardParameters(QTBDashboardParameter::UpdateMode mode)
@@ -86,33 +96,82 @@ void QTBDashboardElement::update(QCPLayoutElement::UpdatePhase phase)
 void QTBDashboardElement::checkParameters()
 {
     for(int i= 0; i< mDashParameters.count();i++) {
-        QSharedPointer<QTBParameter> param;
-        if(mBoard->dataManager())
-            param = mBoard->dataManager()->parameter(mDashParameters.at(i)->getLabel());
-
-        if(param){
-            mDashParameters.at(i)->setUnit(param->unit());
-            mDashParameters.at(i)->setParameterId(param->parameterId());
-        } else {
-            mDashParameters.at(i)->setUnit(QString());
-            mDashParameters.at(i)->setParameterId(0);
-        }
+        QTBParameterBinding binding = bindParameter(mDashParameters.at(i)->getLabel());
+        mDashParameters.at(i)->setUnit(binding.unit);
+        mDashParameters.at(i)->setParameterId(binding.parameterId);
     }
 }
 
+void QTBDashboardElement::rebindParameters()
+{
+    if(mBoard)
+        mBoard->unsubscribeSamples(this);
+    checkParameters();
+    mSamplesChanged = true;
+}
+
+void QTBDashboardElement::parametersRebound()
+{
+    rebindParameters();
+    mBoard->dataHistoryChanged();
+}
+
+bool QTBDashboardElement::needsReplot()
+{
+    if(mSamplesChanged || followsTime())
+        return true;
+    for(int i= 0; i< mDashParameters.count();i++) {
+        if(mDashParameters.at(i)->configurationHasChanged())
+            return true;
+    }
+    return false;
+}
+
+QTBParameterBinding QTBDashboardElement::bindParameter(const QString &label)
+{
+    if(!mResolver && mBoard && mBoard->dataManager())
+        mResolver = mBoard->dataManager()->resolver();
+    if(!mResolver)
+        return QTBParameterBinding();
+
+    QTBParameterBinding binding = mResolver->bind(label, this);
+    if(binding.parameterId)
+        mBoard->subscribeSamples(this, binding.parameterId);
+    return binding;
+}
+
+void QTBDashboardElement::unbindParameter(const QString &label)
+{
+    // the label may still be shown by another parameter of the element
+    for(int i= 0; i< mDashParameters.count();i++) {
+        if(mDashParameters.at(i)->getLabel() == label)
+            return;
+    }
+    if(mResolver)
+        mResolver->unsubscribe(label, this);
+}
+
 void QTBDashboardElement::beforeReplot()
 {
+    bool configurationChanged = false;
     for(int i= 0; i< mDashParameters.count();i++) {
         if(mDashParameters.at(i)->configurationHasChanged()) {
             updateElement();
+            configurationChanged = true;
             break;
         }
     }
 
+    // nothing to refresh while the samples of the element stay the same
+    if(!configurationChanged && !mSamplesChanged && !followsTime())
+        return;
+
     updateDashboardParameters();
 
-    if(mBoard->liveDataRefreshEnabled())
+    if(mBoard->liveDataRefreshEnabled()) {
+        mSamplesChanged = false;
         processNewSamples();
+    }
 }
 
 void QTBDashboardElement::afterReplot()
@@ -190,7 +249,7 @@ void QTBDashboardElement::loadConfigurations(QSettings *settings)
     }
     settings->endArray();
 
-    checkParameters();
+    rebindParameters();
     updateElement();
 }
 
@@ -208,11 +267,17 @@ void QTBDashboardElement::removeDashParameter(int index)
 {
     QSharedPointer<QTBDashboardParameter> dashParam = mDashParameters.takeAt(index);
     mParametersLabel.removeAll(dashParam->getLabel());
+    unbindParameter(dashParam->getLabel());
+    rebindParameters();
     updateElement();
+    mBoard->dataHistoryChanged();
 }
 
 void QTBDashboardElement::removeAllDashParameter()
 {
     mDashParameters.clear();
+    if(mResolver)
+        mResolver->unsubscribe(this);
+    rebindParameters();
     updateElement();
 }
@@ -1,10 +1,12 @@
 #ifndef DASHBOARD_ELEMENT_H
 #define DASHBOARD_ELEMENT_H
 
+#include <QPointer>
 #include "dashboard/layouts/layout_reactive_element.h"
 #include "dashboard/dashboard_parameter.h"
+#include "data/data_resolver.h"
 
-class QTBDashboardElement : public QTBLayoutReactiveElement
+class QTBDashboardElement : public QTBLayoutReactiveElement, public QTBParameterSubscriber
 {
     Q_OBJECT
 public:
@@ -18,6 +20,7 @@ public:
     };
 
     QTBDashboardElement(QTBoard *dashboard = nullptr);
+    ~QTBDashboardElement() Q_DECL_OVERRIDE;
 
     virtual void initializeElement(QTBoard *dashboard) Q_DECL_OVERRIDE;
     virtual void edit() {}
@@ -37,9 +40,20 @@ public:
     virtual void updateDashboardParameters(QTBDashboardParameter::UpdateMode mode = QTBDashboardParameter::umValue);
     virtual void processNewSamples() {}
     virtual void processHistoricalSamples() {}
+    // drops the samples displayed, the data buffer was emptied
+    virtual void clearSamples() {}
     virtual void updateElement() {}
     virtual void update(UpdatePhase phase) Q_DECL_OVERRIDE;
     virtual void checkParameters();
+    // checkParameters() with the samples subscriptions of the element renewed
+    void rebindParameters();
+    void parametersRebound() Q_DECL_OVERRIDE;
+
+    // a sample of the element changed since its last update
+    void samplesChanged() { mSamplesChanged = true; }
+    virtual bool needsReplot();
+    // the element moves with the time even without new samples
+    virtual bool followsTime() const { return false; }
 
     int parametersMaxCount() const;
     void setParametersMaxCount(int parametersMaxCount);
@@ -61,12 +75,21 @@ public:
     virtual void beforeReplot();
     virtual void afterReplot();
 
+    // seconds of data history the element displays
+    virtual double requiredHistory() { return 0; }
+
 protected:
+    // cached id and unit of the label, the element is told when they change
+    QTBParameterBinding bindParameter(const QString &label);
+    void unbindParameter(const QString &label);
+
     int mParametersMaxCount;
     ElementType mType;
     QList<QSharedPointer<QTBDashboardParameter>> mDashParameters;
     QList<QString> mParametersLabel;
     QTBParameterConfiguration::ConfigurationMode mConfigurationMode;
+    QPointer<QTBParameterResolver> mResolver;
+    bool mSamplesChanged{true};
 
 };
 
@@ -177,7 +177,8 @@ bool QTBDashboardParameter::getBitLogic(int bitNumber) const
 void QTBDashboardParameter::update(UpdateMode mode)
 {
     if(mParameterId > 0) {
-        mSample = mBoard->dataManager()->lastSample(mParameterId);
+        if(mBoard->latestSamples())
+            mSample = mBoard->latestSamples()->sample(mParameterId);
         if(mode != umValueOnly) {
             mColor = mParameterConfiguration->defaultColorSettingsRef().color();
             mForegroundColor = mParameterConfiguration->defaultColorSettingsRef().foregroundColor();
@@ -307,7 +308,7 @@ QExplicitlySharedDataPointer<QTBParameterConfiguration> QTBDashboardParameter::e
 double QTBDashboardParameter::getTimestamp() const
 {
     if(mParameterId > 0) {
-        return mSample.datationSecFromMidnight();
+        return mSample.datationSec();
     }
     return 0;
 }
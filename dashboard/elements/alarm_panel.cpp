@@ -207,24 +207,12 @@ void QTBAlarmPanel::processNewSamples()
 
 void QTBAlarmPanel::checkParameters()
 {
-    if(mBoard->dataManager()) {
-        for(int i= 0; i< mDashParameters.count();i++) {
-            if(QSharedPointer<QTBParameter> param = mBoard->dataManager()->parameter(mDashParameters.at(i)->getLabel())) {
-                mDashParameters.at(i)->setParameterId(param->parameterId());
-            } else {
-                mDashParameters.at(i)->setParameterId(0);
-            }
-        }
+    for(int i= 0; i< mDashParameters.count();i++)
+        mDashParameters.at(i)->setParameterId(bindParameter(mDashParameters.at(i)->getLabel()).parameterId);
 
-        for(int i= 0; i< mDashParametersSecondary.count();i++) {
-            if(mDashParametersSecondary.at(i)) {
-                if(QSharedPointer<QTBParameter> param = mBoard->dataManager()->parameter(mDashParametersSecondary.at(i)->getLabel())) {
-                    mDashParametersSecondary.at(i)->setParameterId(param->parameterId());
-                } else {
-                    mDashParametersSecondary.at(i)->setParameterId(0);
-                }
-            }
-        }
+    for(int i= 0; i< mDashParametersSecondary.count();i++) {
+        if(mDashParametersSecondary.at(i))
+            mDashParametersSecondary.at(i)->setParameterId(bindParameter(mDashParametersSecondary.at(i)->getLabel()).parameterId);
     }
 }
 
@@ -317,7 +305,7 @@ void QTBAlarmPanel::updateAlarmConfiguration()
         }
         mDashParametersSecondary.append(dashParam);
     }
-    checkParameters();
+    rebindParameters();
 }
 
 bool QTBAlarmPanel::connected() const
@@ -332,15 +320,26 @@ void QTBAlarmPanel::disconnectAlarmConfig()
     mAlarmConfiguration = mExclusiveAlarmConfiguration;
 }
 
+bool QTBAlarmPanel::needsReplot()
+{
+    return mAlarmConfiguration->modified() || QTBDashboardElement::needsReplot();
+}
+
 void QTBAlarmPanel::beforeReplot()
 {
-    if(mAlarmConfiguration->modified())
+    bool configurationChanged = mAlarmConfiguration->modified();
+    if(configurationChanged)
         updateAlarmConfiguration();
 
+    if(!configurationChanged && !mSamplesChanged)
+        return;
+
     updateDashboardParameters();
 
-    if(mBoard->liveDataRefreshEnabled())
+    if(mBoard->liveDataRefreshEnabled()) {
+        mSamplesChanged = false;
         processNewSamples();
+    }
 }
 
 void QTBAlarmPanel::afterReplot()
@@ -46,6 +46,7 @@ public:
     bool connected() const;
     void disconnectAlarmConfig();
 
+    bool needsReplot() Q_DECL_OVERRIDE;
     void beforeReplot() Q_DECL_OVERRIDE;
     void afterReplot() Q_DECL_OVERRIDE;
 
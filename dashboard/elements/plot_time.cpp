@@ -207,13 +207,8 @@ void QTBPlotTime::addParameter(QSharedPointer<QTBDashboardParameter> dashParamet
         if(legend) {
             legend->addParameter(dashParameter);
             mAxisRect->graphs().last()->data()->clear();
-
-            if(mBoard->dataManager()) {
-                QTBDataSerie serie = mBoard->dataManager()->dataSerie(dashParameter->getParameterId());
-                QCPDataContainer<QTBDataSample>::const_iterator it;
-                for (it = serie.constBegin(); it != serie.constEnd(); ++it)
-                    mAxisRect->graphs().last()->addData(it->datationSecFromMidnight(), it->value().toDouble());
-            }
+            mLastCounters.remove(mAxisRect->graphs().last());
+            appendHistory(mAxisRect->graphs().last(), dashParameter->getParameterId());
         }
     } else {
         auto *legend = new QTBValueDisplay(mBoard);
@@ -236,12 +231,8 @@ void QTBPlotTime::addParameter(QSharedPointer<QTBDashboardParameter> dashParamet
 
         new QTBGraph(mAxisRect->axis(QCPAxis::atBottom), mAxisRect->axis(QCPAxis::atLeft));
 
-        if(mBoard->dataManager()) {
-            QTBDataSerie serie = mBoard->dataManager()->dataSerie(dashParameter->getParameterId());
-            QCPDataContainer<QTBDataSample>::const_iterator it;
-            for (it = serie.constBegin(); it != serie.constEnd(); ++it)
-                mAxisRect->graphs().last()->addData(it->datationSecFromMidnight(), it->value().toDouble());
-        }
+        mLastCounters.remove(mAxisRect->graphs().last());
+        appendHistory(mAxisRect->graphs().last(), dashParameter->getParameterId());
     }
 
     updateElement();
@@ -249,6 +240,7 @@ void QTBPlotTime::addParameter(QSharedPointer<QTBDashboardParameter> dashParamet
 
 void QTBPlotTime::removeDashParameter(int index)
 {
+    mLastCounters.remove(mAxisRect->graphs().at(index));
     mBoard->removeGraph(mAxisRect->graphs().at(index));
     QCPLayoutElement *el = mLegendLayout->takeAt(index + 1);
 
@@ -277,7 +269,7 @@ void QTBPlotTime::processNewSamples()
         QSharedPointer<QTBDashboardParameter> dashParam = dashParameter(i);
         if(dashParam && dashParam->getParameterId() > 0) {
             if(i < mAxisRect->graphs().count()) {
-                mAxisRect->graphs().at(i)->addData(dashParam->getTimestamp(), dashParam->getValueDouble());
+                appendNewSamples(mAxisRect->graphs().at(i), dashParam->getParameterId());
                 mAxisRect->graphs().at(i)->data()->removeBefore(dashParam->getTimestamp()-(mXAxisHistory+1));
             }
         }
@@ -288,19 +280,96 @@ void QTBPlotTime::processNewSamples()
 
 void QTBPlotTime::processHistoricalSamples()
 {
-    if(mBoard->dataManager()) {
-        for(int i=0; i< parametersCount(); i++) {
-            QSharedPointer<QTBDashboardParameter> dashParam = dashParameter(i);
-            if(dashParam) {
-                if(i < mAxisRect->graphs().count()) {
-                    QTBDataSerie serie = mBoard->dataManager()->dataSerie(dashParam->getParameterId());
-                    QCPDataContainer<QTBDataSample>::const_iterator it;
-                    for (it = serie.constBegin(); it != serie.constEnd(); ++it)
-                        mAxisRect->graphs().at(i)->addData(it->datationSecFromMidnight(), it->value().toDouble());
-                }
-            }
+    for(int i=0; i< parametersCount(); i++) {
+        QSharedPointer<QTBDashboardParameter> dashParam = dashParameter(i);
+        if(dashParam) {
+            if(i < mAxisRect->graphs().count())
+                appendHistory(mAxisRect->graphs().at(i), dashParam->getParameterId());
+        }
+    }
+}
+
+void QTBPlotTime::clearSamples()
+{
+    for(int i=0; i< mAxisRect->graphs().count(); i++)
+        mAxisRect->graphs().at(i)->data()->clear();
+    mLastCounters.clear();
+}
+
+void QTBPlotTime::appendNewSamples(QCPGraph *graph, quint32 parameterId)
+{
+    if(mBoard->dataManager() && parameterId > 0) {
+        // only the samples stored since the last call are read from the serie, the graph of a
+        // parameter bound to another serie starts over
+        LastCounter &last = mLastCounters[graph];
+        if(last.parameterId != parameterId) {
+            last.parameterId = parameterId;
+            last.counter = 0;
         }
+        double lastCounter = last.counter;
+
+        QTBDataSerieView serie = mBoard->dataManager()->dataSerie(parameterId);
+        QTBDataSerieView::const_iterator begin = serie.findAfter(lastCounter);
+        int count = serie.constEnd() - begin;
+        if(count <= 0)
+            return;
+
+        QVector<QTBTimestamp> timestamps(count);
+        QVector<double> values(count);
+        serie.copy(begin, count, timestamps.data(), values.data());
+        lastCounter = (serie.constEnd() - 1)->counter();
+        serie.release();
+
+        QVector<double> keys(count);
+        for(int i = 0; i < count; i++)
+            keys[i] = timestampToSec(timestamps.at(i));
+        graph->addData(keys, values);
+
+        last.counter = lastCounter;
+    }
+}
+
+void QTBPlotTime::appendHistory(QCPGraph *graph, quint32 parameterId)
+{
+    // an empty graph starts with the whole history, downsampled when it is dense
+    if(!graph->data()->isEmpty() || !appendEnvelope(graph, parameterId))
+        appendNewSamples(graph, parameterId);
+}
+
+bool QTBPlotTime::appendEnvelope(QCPGraph *graph, quint32 parameterId)
+{
+    const int columns = mAxisRect->width();
+    if(!mBoard->dataManager() || parameterId == 0 || columns <= 0)
+        return false;
+
+    // the min and max of each pixel column, read from the tiers of the serie; the samples
+    // stored afterwards are appended one by one
+    QTBDataSerieView serie = mBoard->dataManager()->dataSerie(parameterId);
+    if(serie.isEmpty())
+        return false;
+    const QTBDataSample last = *(serie.constEnd() - 1);
+    const QTBTimestamp end = last.timestamp();
+    const QTBTimestamp begin = end - timestampFromSec(mXAxisHistory);
+    if(serie.constEnd() - serie.findTimestamp(begin) < GRAPHPLOT_ENVELOPE_MIN_SAMPLES * columns)
+        return false;
+    const QVector<QTBDataEnvelope> envelopes = serie.envelope(begin, end, columns);
+    serie.release();
+
+    QVector<double> keys;
+    QVector<double> values;
+    keys.reserve(2 * envelopes.count());
+    values.reserve(2 * envelopes.count());
+    for(const QTBDataEnvelope &envelope : envelopes) {
+        const double key = timestampToSec(envelope.timestamp);
+        keys << key << key;
+        values << envelope.min << envelope.max;
     }
+    graph->addData(keys, values, true);
+
+    LastCounter &lastCounter = mLastCounters[graph];
+    lastCounter.parameterId = parameterId;
+    lastCounter.counter = last.counter();
+    return true;
 }
 
 void QTBPlotTime::updateLegendSize()
@@ -891,7 +960,11 @@ int QTBPlotTime::xAxisHistory() const
 
 void QTBPlotTime::setXAxisHistory(int xAxisHistory)
 {
-    mXAxisHistory = xAxisHistory;
+    if(mXAxisHistory != xAxisHistory) {
+        mXAxisHistory = xAxisHistory;
+        if(mBoard)
+            mBoard->dataHistoryChanged();
+    }
 }
 
 QTBPlotTime::XAxisDirection QTBPlotTime::xAxisDirection() const
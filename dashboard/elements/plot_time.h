@@ -8,6 +8,8 @@
 #include "dashboard/elements_factory/elementfactory.h"
 
 #define GRAPHPLOT_NAME "Plot - Graphs Y=f(t)"
+// a history with more samples per pixel column is drawn from the envelope of the serie
+#define GRAPHPLOT_ENVELOPE_MIN_SAMPLES 4
 
 class QTBPlotTime : public QTBDashboardElement
 {
@@ -55,6 +57,12 @@ public:
     void updateElement() Q_DECL_OVERRIDE;
     void processNewSamples() Q_DECL_OVERRIDE;
     void processHistoricalSamples() Q_DECL_OVERRIDE;
+    void clearSamples() Q_DECL_OVERRIDE;
+    double requiredHistory() Q_DECL_OVERRIDE { return mXAxisHistory + 1; }
+    bool followsTime() const Q_DECL_OVERRIDE { return true; }
+    void appendNewSamples(QCPGraph *graph, quint32 parameterId);
+    void appendHistory(QCPGraph *graph, quint32 parameterId);
+    bool appendEnvelope(QCPGraph *graph, quint32 parameterId);
 
     void updateLegendSize();
     void updateAxes();
@@ -93,6 +101,13 @@ public:
     void setThresholdsVisible(bool thresholdsVisible);
 
 protected:
+    // last sample read by a graph, from the serie it was read from
+    struct LastCounter
+    {
+        quint32 parameterId{0};
+        double counter{0};
+    };
+
     QCPLayoutGrid *mLayout;
     QTBLayoutGrid *mLegendLayout{};
     QCPLayoutElement *mLegendEmptyElementFirst{};
@@ -114,6 +129,7 @@ protected:
     XAxisDirection mXAxisDirection;
     bool mThresholdsVisible;
     QCPRange mAutoRange;
+    QHash<QCPGraph *, LastCounter> mLastCounters;
 };
 
 static ElementRegister<QTBPlotTime> graphRegister(QString(GRAPHPLOT_NAME), QTBDashboardElement::etMultiParam, ":/elements/icons8_cosine_50px.png");
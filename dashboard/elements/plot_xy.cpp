@@ -225,14 +225,11 @@ void QTBPlotXY::checkParameters()
 {
     QTBDashboardElement::checkParameters();
 
-    QSharedPointer<QTBParameter> param;
-    if(mBoard->dataManager()) {
-        if(mXParameter) {
-            param = mBoard->dataManager()->parameter(mXParameter->getLabel());
-            if(param){
-                mXParameter->setUnit(param->unit());
-                mXParameter->setParameterId(param->parameterId());
-            }
+    if(mXParameter) {
+        QTBParameterBinding binding = bindParameter(mXParameter->getLabel());
+        if(binding.parameterId) {
+            mXParameter->setUnit(binding.unit);
+            mXParameter->setParameterId(binding.parameterId);
         }
     }
 }
@@ -510,6 +507,12 @@ QSharedPointer<QTBDashboardParameter> QTBPlotXY::addXParameter(const QSharedPoin
     return mXParameter;
 }
 
+void QTBPlotXY::clearSamples()
+{
+    for(int i=0; i< mCurves.count();i++)
+        mCurves.at(i)->data()->clear();
+}
+
 void QTBPlotXY::removeYParameter(int index)
 {
     QCPCurve *curve = mCurves.takeAt(index);
@@ -59,6 +59,7 @@ public:
     void updateDashboardParameters(QTBDashboardParameter::UpdateMode mode = QTBDashboardParameter::umValue) Q_DECL_OVERRIDE;
     void updateElement() Q_DECL_OVERRIDE;
     void processNewSamples() Q_DECL_OVERRIDE;
+    void clearSamples() Q_DECL_OVERRIDE;
 
     void updateLegendSize();
     void updateAxes();
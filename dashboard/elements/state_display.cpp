@@ -40,17 +40,8 @@ void QTBStateDisplay::saveSettings(QSettings *settings)
 void QTBStateDisplay::checkParameters()
 {
     for(int i= 0; i< mDashParameters.count();i++) {
-        QSharedPointer<QTBParameter> param;
-        if(mBoard->dataManager())
-            param = mBoard->dataManager()->parameter(mDashParameters.at(i)->getLabel());
-
-        if(param){
-            mDashParameters.at(i)->setUnit(QString());
-            mDashParameters.at(i)->setParameterId(param->parameterId());
-        } else {
-            mDashParameters.at(i)->setUnit(QString());
-            mDashParameters.at(i)->setParameterId(0);
-        }
+        mDashParameters.at(i)->setUnit(QString());
+        mDashParameters.at(i)->setParameterId(bindParameter(mDashParameters.at(i)->getLabel()).parameterId);
     }
 }
 
@@ -253,16 +253,35 @@ void QTBValueBitfields::processNewSamples()
     }
 }
 
+void QTBValueBitfields::clearSamples()
+{
+    for(int i=0; i< mGraphs.count(); i++)
+        mGraphs.at(i)->data()->clear();
+}
+
 void QTBValueBitfields::processHistoricalSamples()
 {
     QSharedPointer<QTBDashboardParameter> dashParam = dashParameter(0);
     if(dashParam) {
 
         if(mBoard->dataManager()) {
-            QTBDataSerie serie = mBoard->dataManager()->dataSerie(dashParam->getParameterId());
-            QCPDataContainer<QTBDataSample>::const_iterator it;
+            // the raw words are copied out, the serie is not locked while the graphs are filled
+            QTBDataSerieView serie = mBoard->dataManager()->dataSerie(dashParam->getParameterId());
+            const int count = serie.constEnd() - serie.constBegin();
+            QVector<double> keys;
+            QVector<quint32> words;
+            keys.reserve(count);
+            words.reserve(count);
+            QTBDataSerieView::const_iterator it;
             for (it = serie.constBegin(); it != serie.constEnd(); ++it) {
-                std::bitset<32> bits(it->value().uint32_value());
+                keys.append(it->datationSec());
+                words.append(it->value().uint32_value());
+            }
+            serie.release();
+
+            for (int k = 0; k < keys.count(); ++k) {
+                std::bitset<32> bits(words.at(k));
+                double key = keys.at(k);
 
                 std::size_t bitIndex = 0;
                 int graphIndex = 0;
@@ -292,14 +311,14 @@ void QTBValueBitfields::processHistoricalSamples()
 
                     if(dashParam->getBitLogic(int(bitIndex))) {
                         if(!bits.test(bitIndex))
-                            mGraphs.at(graphIndex)->addData(it->datationSecFromMidnight(), qQNaN());
+                            mGraphs.at(graphIndex)->addData(key, qQNaN());
                         else
-                            mGraphs.at(graphIndex)->addData(it->datationSecFromMidnight(), double(bitIndex) +0.9);
+                            mGraphs.at(graphIndex)->addData(key, double(bitIndex) +0.9);
                     } else {
                         if(bits.test(bitIndex))
-                            mGraphs.at(graphIndex)->addData(it->datationSecFromMidnight(), qQNaN());
+                            mGraphs.at(graphIndex)->addData(key, qQNaN());
                         else
-                            mGraphs.at(graphIndex)->addData(it->datationSecFromMidnight(), double(bitIndex) +0.9);
+                            mGraphs.at(graphIndex)->addData(key, double(bitIndex) +0.9);
                     }
                 }
             }
@@ -28,6 +28,9 @@ public:
 
     void processNewSamples() Q_DECL_OVERRIDE;
     void processHistoricalSamples() Q_DECL_OVERRIDE;
+    void clearSamples() Q_DECL_OVERRIDE;
+    double requiredHistory() Q_DECL_OVERRIDE { return 6; }
+    bool followsTime() const Q_DECL_OVERRIDE { return true; }
     void updateElement() Q_DECL_OVERRIDE;
 
     void updateSizeConstraints() Q_DECL_OVERRIDE;
@@ -8,19 +8,36 @@ DEFINES += QCUSTOMPLOT_USE_OPENGL
 HEADERS += \
     $$PWD/../3rdparty/csv.h \
     $$PWD/../3rdparty/qcustomplot.h \
+    $$PWD/data_archive.h \
+    $$PWD/data_archive_codec.h \
     $$PWD/data_buffer.h \
+    $$PWD/data_catalog.h \
+    $$PWD/data_common.h \
     $$PWD/data_source.h \
     $$PWD/data_source_interface.h \
     $$PWD/data_manager.h \
     $$PWD/data_sample.h \
+    $$PWD/data_sample_queue.h \
     $$PWD/data_serie.h \
+    $$PWD/data_serie_tiers.h \
+    $$PWD/data_snapshot.h \
+    $$PWD/data_timestamp.h \
     $$PWD/data_parameter.h \
+    $$PWD/data_replay.h \
+    $$PWD/data_resolver.h \
+    $$PWD/data_export.h \
     $$PWD/data_value.h
 
 SOURCES += \
     $$PWD/../3rdparty/qcustomplot.cpp \
+    $$PWD/data_archive.cpp \
     $$PWD/data_buffer.cpp \
+    $$PWD/data_catalog.cpp \
     $$PWD/data_parameter.cpp \
+    $$PWD/data_replay.cpp \
+    $$PWD/data_resolver.cpp \
+    $$PWD/data_snapshot.cpp \
+    $$PWD/data_export.cpp \
     $$PWD/data_manager.cpp
 
 INCLUDEPATH += $$PWD/..
@@ -0,0 +1,513 @@
+#include "data_archive.h"
+#include "data_manager.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QDebug>
+#include <limits>
+
+QTBDataArchiveStream::QTBDataArchiveStream(const QString &sourceName, const QString &path) :
+    mSourceName(sourceName),
+    mPath(path),
+    mQueue(ARCHIVE_QUEUE_CAPACITY),
+    mEncodedSamples(0),
+    mSegmentFirst(0)
+{
+}
+
+QTBDataArchive::QTBDataArchive(QTBDataManager *dataManager, const QString &path, QObject *parent) :
+    QObject(parent),
+    mDataManager(dataManager),
+    mPath(path),
+    mReadCount(0)
+{
+    QDir().mkpath(mPath);
+
+    mThread = new QThread(this);
+    mRecordTimer = new QTimer(nullptr); // _not_ this!
+    mRecordTimer->setInterval(ARCHIVE_RECORD_PERIOD_MS);
+    mRecordTimer->moveToThread(mThread);
+    connect(mRecordTimer, SIGNAL(timeout()), SLOT(record()), Qt::DirectConnection);
+    connect(mThread, SIGNAL (finished()), mRecordTimer, SLOT (deleteLater()));
+    mRecordTimer->connect(mThread, SIGNAL(started()), SLOT(start()));
+    mFlushClock.start();
+}
+
+QTBDataArchive::~QTBDataArchive()
+{
+    stop();
+    qDeleteAll(mStreams);
+}
+
+QTBDataArchiveStream *QTBDataArchive::stream(const QString &sourceName)
+{
+    QTBDataArchiveStream *stream = mStreams.value(sourceName, nullptr);
+    if(!stream) {
+        QString sourcePath = mPath + QDir::separator() + sourceName;
+        QDir().mkpath(sourcePath);
+
+        stream = new QTBDataArchiveStream(sourceName, sourcePath);
+        stream->mCatalog = catalog(sourceName);
+        stream->mCatalogFile.setFileName(sourcePath + QDir::separator() + QString(ARCHIVE_CATALOG_FILE));
+        if(!stream->mCatalogFile.open(QIODevice::Append | QIODevice::Text))
+            qWarning() << "Can't open archive catalog" << stream->mCatalogFile.fileName();
+        mStreams.insert(sourceName, stream);
+    }
+    return stream;
+}
+
+void QTBDataArchive::start()
+{
+    if(!mThread->isRunning())
+        mThread->start();
+}
+
+void QTBDataArchive::stop()
+{
+    if(mThread->isRunning()) {
+        mThread->quit();
+        mThread->wait();
+    }
+
+    // what the sources pushed last
+    flush();
+
+    for(QTBDataArchiveStream *stream : mStreams) {
+        stream->mSegment.close();
+        stream->mCatalogFile.close();
+    }
+}
+
+QStringList QTBDataArchive::sources() const
+{
+    return QDir(mPath).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+}
+
+QStringList QTBDataArchive::labels(const QString &sourceName) const
+{
+    QStringList labels = catalog(sourceName).keys();
+    labels.sort();
+    return labels;
+}
+
+QHash<QString, quint32> QTBDataArchive::catalog(const QString &sourceName) const
+{
+    QMutexLocker locker(&mCatalogLock);
+    QHash<QString, QHash<QString, quint32>>::iterator it = mCatalogs.find(sourceName);
+    if(it == mCatalogs.end())
+        it = mCatalogs.insert(sourceName, loadCatalog(mPath + QDir::separator() + sourceName));
+    return it.value();
+}
+
+void QTBDataArchive::releaseSeries(const QVector<quint32> &serieIndexes)
+{
+    QMutexLocker locker(&mReleasedLock);
+    mReleasedSeries += serieIndexes;
+}
+
+void QTBDataArchive::forgetReleasedSeries()
+{
+    QVector<quint32> released;
+    {
+        QMutexLocker locker(&mReleasedLock);
+        released.swap(mReleasedSeries);
+    }
+
+    // the samples still queued for them are looked up again, or left out once they are gone
+    for(QTBDataArchiveStream *stream : mStreams) {
+        for(quint32 serieIndex : released)
+            stream->mCatalogIds.remove(serieIndex);
+    }
+}
+
+void QTBDataArchive::record()
+{
+    forgetReleasedSeries();
+    for(QTBDataArchiveStream *stream : mStreams)
+        encode(stream);
+
+    if(mFlushClock.elapsed() >= ARCHIVE_FLUSH_PERIOD_MS) {
+        mFlushClock.restart();
+        for(QTBDataArchiveStream *stream : mStreams)
+            write(stream);
+    }
+}
+
+void QTBDataArchive::flush()
+{
+    forgetReleasedSeries();
+    for(QTBDataArchiveStream *stream : mStreams) {
+        encode(stream);
+        write(stream);
+    }
+}
+
+void QTBDataArchive::encode(QTBDataArchiveStream *stream)
+{
+    quint32 &encodedSamples = stream->mEncodedSamples;
+    stream->mQueue.drain([this, stream, &encodedSamples](const QTBDataRecord &record) {
+        // samples of parameters not registered are not archived
+        quint32 id = catalogId(stream, record.serieIndex);
+        if(id == 0)
+            return;
+
+        quint32 parameter = id | (quint32(record.value.mType) << ARCHIVE_TYPE_SHIFT);
+        stream->mEncoders[parameter].add(record.value.mType, record.timestamp, record.value.mValue.ui32);
+        encodedSamples++;
+    });
+
+    // bounds the memory held by a burst
+    if(encodedSamples >= ARCHIVE_CHUNK_MAX_SAMPLES)
+        write(stream);
+}
+
+void QTBDataArchive::write(QTBDataArchiveStream *stream)
+{
+    if(stream->mEncodedSamples == 0)
+        return;
+
+    QTBArchiveChunkHeader header;
+    header.magic = ARCHIVE_CHUNK_MAGIC;
+    header.count = 0;
+    header.blocks = 0;
+    header.bytes = 0;
+    header.first = std::numeric_limits<qint64>::max();
+    header.last = std::numeric_limits<qint64>::min();
+
+    QHash<quint32, QTBArchiveEncoder>::iterator it;
+    for(it = stream->mEncoders.begin(); it != stream->mEncoders.end(); ++it) {
+        if(it.value().count() > 0) {
+            header.blocks++;
+            header.bytes += quint32(sizeof(QTBArchiveBlockHeader)) + quint32(it.value().wordCount()) * quint32(sizeof(quint64));
+        }
+    }
+
+    QByteArray chunk(int(sizeof(QTBArchiveChunkHeader) + header.bytes), Qt::Uninitialized);
+    char *block = chunk.data() + sizeof(QTBArchiveChunkHeader);
+
+    it = stream->mEncoders.begin();
+    while(it != stream->mEncoders.end()) {
+        QTBArchiveEncoder &encoder = it.value();
+        // parameters that went quiet give their encoder back
+        if(encoder.count() == 0) {
+            it = stream->mEncoders.erase(it);
+            continue;
+        }
+
+        QTBArchiveBlockHeader blockHeader;
+        blockHeader.parameter = it.key();
+        blockHeader.count = encoder.count();
+        blockHeader.words = quint32(encoder.wordCount());
+        blockHeader.reserved = 0;
+        blockHeader.first = encoder.first();
+        blockHeader.last = encoder.last();
+        memcpy(block, &blockHeader, sizeof(QTBArchiveBlockHeader));
+        block += sizeof(QTBArchiveBlockHeader);
+        memcpy(block, encoder.words(), size_t(encoder.wordCount()) * sizeof(quint64));
+        block += size_t(encoder.wordCount()) * sizeof(quint64);
+
+        header.count += encoder.count();
+        header.first = qMin(header.first, encoder.first());
+        header.last = qMax(header.last, encoder.last());
+        encoder.clear();
+        ++it;
+    }
+    stream->mEncodedSamples = 0;
+    memcpy(chunk.data(), &header, sizeof(QTBArchiveChunkHeader));
+
+    if(openSegment(stream, header.first)) {
+        // one write per chunk, readers ignore a chunk that is not complete yet
+        stream->mSegment.write(chunk);
+        stream->mSegment.flush();
+
+        // readers map the segment again once it has grown
+        QMutexLocker locker(&mIndexLock);
+        mSegmentIndexes[stream->mSegment.fileName()].size = stream->mSegment.size();
+    }
+}
+
+bool QTBDataArchive::openSegment(QTBDataArchiveStream *stream, QTBTimestamp first)
+{
+    if(stream->mSegment.isOpen()) {
+        if(stream->mSegment.size() < qint64(ARCHIVE_SEGMENT_SIZE_MB) * 1024 * 1024 &&
+                first - stream->mSegmentFirst < ARCHIVE_SEGMENT_DURATION_SEC * TIMESTAMP_NS_PER_SEC)
+            return true;
+        stream->mSegment.close();
+    }
+
+    stream->mSegmentFirst = first;
+    stream->mSegment.setFileName(stream->mPath + QDir::separator() +
+                                 QString("%1.%2").arg(first, 20, 10, QChar('0')).arg(ARCHIVE_SEGMENT_SUFFIX));
+    if(!stream->mSegment.open(QIODevice::Append)) {
+        qWarning() << "Can't open archive segment" << stream->mSegment.fileName();
+        return false;
+    }
+
+    QMutexLocker locker(&mIndexLock);
+    mSegmentFiles.remove(stream->mSourceName);
+    return true;
+}
+
+quint32 QTBDataArchive::catalogId(QTBDataArchiveStream *stream, quint32 serieIndex)
+{
+    QHash<quint32, quint32>::const_iterator it = stream->mCatalogIds.constFind(serieIndex);
+    if(it != stream->mCatalogIds.constEnd())
+        return it.value();
+
+    QSharedPointer<QTBParameter> param = mDataManager->parameter(serieIndex);
+    if(!param)
+        return 0;
+
+    // ids are kept across sessions, new labels are appended to the catalog
+    quint32 id = stream->mCatalog.value(param->label(), 0);
+    if(id == 0) {
+        id = quint32(stream->mCatalog.count()) + 1;
+        stream->mCatalog.insert(param->label(), id);
+        QTextStream(&stream->mCatalogFile) << id << ';' << param->label() << '\n';
+        stream->mCatalogFile.flush();
+
+        QMutexLocker locker(&mCatalogLock);
+        mCatalogs[stream->mSourceName].insert(param->label(), id);
+    }
+
+    stream->mCatalogIds.insert(serieIndex, id);
+    return id;
+}
+
+QHash<QString, quint32> QTBDataArchive::loadCatalog(const QString &sourcePath) const
+{
+    QHash<QString, quint32> catalog;
+    QFile file(sourcePath + QDir::separator() + QString(ARCHIVE_CATALOG_FILE));
+    if(file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream in(&file);
+        while(!in.atEnd()) {
+            QString line = in.readLine();
+            int separator = line.indexOf(';');
+            if(separator > 0)
+                catalog.insert(line.mid(separator + 1), line.left(separator).toUInt());
+        }
+    }
+    return catalog;
+}
+
+QStringList QTBDataArchive::segments(const QString &sourcePath) const
+{
+    // the names are zero padded, sorting them sorts the segments in time
+    return QDir(sourcePath).entryList(QStringList() << QString("*.%1").arg(ARCHIVE_SEGMENT_SUFFIX),
+                                      QDir::Files, QDir::Name);
+}
+
+QStringList QTBDataArchive::segmentFiles(const QString &sourceName) const
+{
+    QHash<QString, QStringList>::iterator it = mSegmentFiles.find(sourceName);
+    if(it == mSegmentFiles.end()) {
+        const QString sourcePath = mPath + QDir::separator() + sourceName;
+        QStringList files;
+        for(const QString &segment : segments(sourcePath))
+            files.append(sourcePath + QDir::separator() + segment);
+        it = mSegmentFiles.insert(sourceName, files);
+    }
+    return it.value();
+}
+
+void QTBDataArchive::indexSegment(SegmentIndex &index, const uchar *data, qint64 size) const
+{
+    while(index.scanned + qint64(sizeof(QTBArchiveChunkHeader)) <= size) {
+        QTBArchiveChunkHeader header;
+        memcpy(&header, data + index.scanned, sizeof(QTBArchiveChunkHeader));
+        qint64 end = index.scanned + qint64(sizeof(QTBArchiveChunkHeader)) + qint64(header.bytes);
+        if(header.magic != ARCHIVE_CHUNK_MAGIC || end > size)
+            break;
+
+        ChunkEntry entry;
+        entry.offset = index.scanned;
+        entry.first = header.first;
+        entry.last = header.last;
+        entry.count = header.count;
+        entry.blocks = header.blocks;
+        index.last = index.chunks.isEmpty() ? header.last : qMax(index.last, header.last);
+        index.chunks.append(entry);
+        index.scanned = end;
+    }
+}
+
+void QTBDataArchive::read(const QString &sourceName, const QString &label,
+                          QTBTimestamp begin, QTBTimestamp end,
+                          const std::function<void(QTBTimestamp, QTBDataValue)> &func) const
+{
+    quint32 id = catalog(sourceName).value(label, 0);
+    if(id == 0)
+        return;
+
+    QBitArray ids(int(id) + 1);
+    ids.setBit(int(id));
+    scan(sourceName, ids, begin, end, [&func](quint32 recordId, QTBTimestamp timestamp, QTBDataValue value) {
+        Q_UNUSED(recordId)
+        func(timestamp, value);
+    });
+}
+
+void QTBDataArchive::read(const QString &sourceName,
+                          QTBTimestamp begin, QTBTimestamp end,
+                          const std::function<void(quint32, QTBTimestamp, QTBDataValue)> &func) const
+{
+    scan(sourceName, QBitArray(), begin, end, func);
+}
+
+void QTBDataArchive::read(const QString &sourceName, const QBitArray &ids,
+                          QTBTimestamp begin, QTBTimestamp end,
+                          const std::function<void(quint32, QTBTimestamp, QTBDataValue)> &func) const
+{
+    if(ids.count(true) > 0)
+        scan(sourceName, ids, begin, end, func);
+}
+
+void QTBDataArchive::scan(const QString &sourceName, const QBitArray &ids,
+                          QTBTimestamp begin, QTBTimestamp end,
+                          const std::function<void(quint32, QTBTimestamp, QTBDataValue)> &func) const
+{
+    QStringList files;
+    {
+        QMutexLocker locker(&mIndexLock);
+        files = segmentFiles(sourceName);
+    }
+
+    for(const QString &fileName : files) {
+        if(QFileInfo(fileName).baseName().toLongLong() > end)
+            break;
+
+        // the chunks in range are picked under the lock, decoded and handed out without it
+        QSharedPointer<SegmentMapping> mapping;
+        QVector<ChunkEntry> chunks;
+        {
+            QMutexLocker locker(&mIndexLock);
+
+            // a segment indexed to its end which is over before the range is not even mapped
+            QHash<QString, SegmentIndex>::const_iterator it = mSegmentIndexes.constFind(fileName);
+            if(it != mSegmentIndexes.constEnd() && !it.value().chunks.isEmpty() &&
+                    it.value().last < begin && it.value().scanned == it.value().size)
+                continue;
+
+            const SegmentIndex *index = mapSegment(fileName);
+            if(!index)
+                continue;
+            mapping = index->mapping;
+            for(const ChunkEntry &chunk : index->chunks) {
+                if(chunk.last >= begin && chunk.first <= end)
+                    chunks.append(chunk);
+            }
+        }
+
+        const uchar *data = mapping->data;
+        for(const ChunkEntry &chunk : chunks) {
+            const uchar *block = data + chunk.offset + sizeof(QTBArchiveChunkHeader);
+            for(quint32 i = 0; i < chunk.blocks; i++) {
+                QTBArchiveBlockHeader blockHeader;
+                memcpy(&blockHeader, block, sizeof(QTBArchiveBlockHeader));
+                const quint64 *words = reinterpret_cast<const quint64*>(block + sizeof(QTBArchiveBlockHeader));
+                block += sizeof(QTBArchiveBlockHeader) + size_t(blockHeader.words) * sizeof(quint64);
+
+                // only the blocks of the parameters overlapping the range are decoded
+                const quint32 blockId = blockHeader.parameter & ARCHIVE_ID_MASK;
+                if(!ids.isEmpty() && (blockId >= quint32(ids.size()) || !ids.testBit(int(blockId))))
+                    continue;
+                if(blockHeader.last < begin || blockHeader.first > end)
+                    continue;
+
+                QTBDataValue value;
+                value.mType = QTBDataValue::ValueType(blockHeader.parameter >> ARCHIVE_TYPE_SHIFT);
+                QTBArchiveDecoder decoder(value.mType, words, int(blockHeader.words));
+                for(quint32 j = 0; j < blockHeader.count; j++) {
+                    QTBTimestamp timestamp;
+                    decoder.next(&timestamp, &value.mValue.ui32);
+                    if(timestamp >= begin && timestamp <= end)
+                        func(blockId, timestamp, value);
+                }
+            }
+        }
+    }
+}
+
+const QTBDataArchive::SegmentIndex *QTBDataArchive::mapSegment(const QString &fileName) const
+{
+    // the segments the recording doesn't write don't change, their size is read once
+    SegmentIndex &index = mSegmentIndexes[fileName];
+    if(index.size < 0)
+        index.size = QFileInfo(fileName).size();
+    index.used = ++mReadCount;
+
+    // mapped again only when it has grown since
+    if(!index.mapping || index.mapping->size < index.size) {
+        QSharedPointer<SegmentMapping> mapping(new SegmentMapping(fileName));
+        if(index.size <= 0 || !mapping->file.open(QIODevice::ReadOnly))
+            return nullptr;
+        mapping->data = mapping->file.map(0, index.size);
+        if(!mapping->data)
+            return nullptr;
+        mapping->size = index.size;
+        index.mapping = mapping;
+        releaseMappings();
+    }
+
+    // chunk headers are only walked once, the index follows the segment being written
+    if(index.scanned > index.mapping->size) {
+        index.scanned = 0;
+        index.chunks.clear();
+    }
+    indexSegment(index, index.mapping->data, index.mapping->size);
+    return &index;
+}
+
+void QTBDataArchive::releaseMappings() const
+{
+    int mapped = 0;
+    for(const SegmentIndex &index : mSegmentIndexes) {
+        if(index.mapping)
+            mapped++;
+    }
+
+    // a read still decoding a segment keeps its mapping until it is done
+    while(mapped > ARCHIVE_MAPPED_SEGMENTS) {
+        SegmentIndex *oldest = nullptr;
+        QHash<QString, SegmentIndex>::iterator it;
+        for(it = mSegmentIndexes.begin(); it != mSegmentIndexes.end(); ++it) {
+            if(it.value().mapping && (!oldest || it.value().used < oldest->used))
+                oldest = &it.value();
+        }
+        oldest->mapping.reset();
+        mapped--;
+    }
+}
+
+bool QTBDataArchive::timeRange(QTBTimestamp *first, QTBTimestamp *last) const
+{
+    bool found = false;
+    QMutexLocker locker(&mIndexLock);
+    for(const QString &sourceName : sources()) {
+        QStringList files = segmentFiles(sourceName);
+        if(files.isEmpty())
+            continue;
+
+        // segments start with their first timestamp, only the last one is read
+        QTBTimestamp sourceFirst = QFileInfo(files.first()).baseName().toLongLong();
+        QTBTimestamp sourceLast = sourceFirst;
+        const SegmentIndex *index = mapSegment(files.last());
+        if(index && !index->chunks.isEmpty())
+            sourceLast = qMax(sourceLast, index->last);
+
+        *first = found ? qMin(*first, sourceFirst) : sourceFirst;
+        *last = found ? qMax(*last, sourceLast) : sourceLast;
+        found = true;
+    }
+    return found;
+}
+
+QVector<QTBDataSample> QTBDataArchive::samples(const QString &sourceName, const QString &label,
+                                               QTBTimestamp begin, QTBTimestamp end) const
+{
+    QVector<QTBDataSample> samples;
+    read(sourceName, label, begin, end, [&samples](QTBTimestamp timestamp, QTBDataValue value) {
+        samples.append(QTBDataSample(double(samples.count()), timestamp, value));
+    });
+    return samples;
+}
@@ -0,0 +1,236 @@
+#ifndef DATA_ARCHIVE_H
+#define DATA_ARCHIVE_H
+
+#include <QObject>
+#include <QMap>
+#include <QHash>
+#include <QBitArray>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QFile>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <functional>
+#include "data_sample.h"
+#include "data_sample_queue.h"
+#include "data_archive_codec.h"
+
+#define ARCHIVE_RECORD_PERIOD_MS 20
+#define ARCHIVE_FLUSH_PERIOD_MS 1000
+#define ARCHIVE_QUEUE_CAPACITY 262144
+#define ARCHIVE_CHUNK_MAX_SAMPLES 1048576
+#define ARCHIVE_SEGMENT_SIZE_MB 256
+#define ARCHIVE_SEGMENT_DURATION_SEC 3600
+#define ARCHIVE_CHUNK_MAGIC 0x5A425451 // "QTBZ"
+#define ARCHIVE_SEGMENT_SUFFIX "qtbs"
+#define ARCHIVE_CATALOG_FILE "catalog.txt"
+// segments kept mapped between reads, the least recently read are unmapped
+#define ARCHIVE_MAPPED_SEGMENTS 16
+
+/* On disk, native byte order:
+ *   <archive>/<source>/catalog.txt         "id;label" lines, append only
+ *   <archive>/<source>/<first ns>.qtbs     segment, a sequence of chunks
+ * A chunk is a header followed by one block per parameter, a block is a
+ * header followed by the compressed samples (see data_archive_codec.h),
+ * padded to 64 bits. Segments are named after the first timestamp they
+ * hold, a time range only maps the segments and decodes the blocks it
+ * overlaps. */
+struct QTBArchiveChunkHeader
+{
+    quint32 magic;
+    quint32 count;
+    quint32 blocks;
+    quint32 bytes;      // size of the blocks
+    qint64  first;
+    qint64  last;
+};
+
+struct QTBArchiveBlockHeader
+{
+    quint32 parameter;  // catalog id on the low 24 bits, value type above
+    quint32 count;
+    quint32 words;      // 64 bit words of compressed samples
+    quint32 reserved;
+    qint64  first;
+    qint64  last;
+};
+
+#define ARCHIVE_ID_MASK 0x00FFFFFF
+#define ARCHIVE_TYPE_SHIFT 24
+
+class QTBDataManager;
+
+/* Recording side of one data source. The acquisition thread pushes its
+ * samples here as well as in the merge queue of the source, the archive
+ * thread drains them every few ms and compresses them per parameter, then
+ * writes them as one chunk every second: neither disk latency nor the
+ * merge period reach the recording. When the archive falls behind, new
+ * samples are dropped and counted. */
+class QTBDataArchiveStream
+{
+public:
+    QTBDataArchiveStream(const QString &sourceName, const QString &path);
+
+    // producer side, same thread as the data source queue
+    bool push(quint32 serieIndex, QTBTimestamp timestamp, QTBDataValue value)
+    {
+        return mQueue.push(serieIndex, timestamp, value);
+    }
+
+    quint32 push(const QTBDataRecord *records, quint32 count)
+    {
+        return mQueue.push(records, count);
+    }
+
+    quint32 push(QTBTimestamp timestamp, const quint32 *serieIndexes, const QTBDataValue *values, quint32 count)
+    {
+        return mQueue.push(timestamp, serieIndexes, values, count);
+    }
+
+    QString sourceName() const { return mSourceName; }
+    quint64 droppedSamples() const { return mQueue.overflowCount(); }
+
+private:
+    Q_DISABLE_COPY(QTBDataArchiveStream)
+    friend class QTBDataArchive;
+
+    QString mSourceName;
+    QString mPath;
+    QTBDataSampleQueue mQueue;
+
+    // archive thread only
+    QHash<quint32, QTBArchiveEncoder> mEncoders;  // by block parameter
+    quint32 mEncodedSamples;
+    QFile mSegment;
+    QTBTimestamp mSegmentFirst;
+    QFile mCatalogFile;
+    QHash<QString, quint32> mCatalog;
+    // serie index to catalog id, see QTBDataArchive::releaseSeries()
+    QHash<quint32, quint32> mCatalogIds;
+};
+
+/* Append-only archive of the samples of every data source, one directory
+ * per source. Recording runs on its own thread, reads map the segment
+ * files so that a long archive is never loaded in memory. */
+class QTBDataArchive : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QTBDataArchive(QTBDataManager *dataManager, const QString &path, QObject *parent = nullptr);
+    ~QTBDataArchive();
+
+    // streams are created before start()
+    QTBDataArchiveStream *stream(const QString &sourceName);
+    void start();
+    void stop();
+    // serie indexes of unregistered parameters, their slot may come back for another label
+    void releaseSeries(const QVector<quint32> &serieIndexes);
+
+    QString path() const { return mPath; }
+    QStringList sources() const;
+    QStringList labels(const QString &sourceName) const;
+    QHash<QString, quint32> catalog(const QString &sourceName) const;
+    bool timeRange(QTBTimestamp *first, QTBTimestamp *last) const;
+
+    // calls func for every archived sample of the parameter in [begin, end]
+    void read(const QString &sourceName, const QString &label,
+              QTBTimestamp begin, QTBTimestamp end,
+              const std::function<void(QTBTimestamp, QTBDataValue)> &func) const;
+    QVector<QTBDataSample> samples(const QString &sourceName, const QString &label,
+                                   QTBTimestamp begin, QTBTimestamp end) const;
+    // every parameter of the source in one pass, func gets the catalog id
+    void read(const QString &sourceName,
+              QTBTimestamp begin, QTBTimestamp end,
+              const std::function<void(quint32, QTBTimestamp, QTBDataValue)> &func) const;
+    // the parameters whose catalog id is set in ids, in one pass
+    void read(const QString &sourceName, const QBitArray &ids,
+              QTBTimestamp begin, QTBTimestamp end,
+              const std::function<void(quint32, QTBTimestamp, QTBDataValue)> &func) const;
+
+public slots:
+    void record();
+    void flush();
+
+private:
+    struct ChunkEntry
+    {
+        qint64          offset;
+        QTBTimestamp    first;
+        QTBTimestamp    last;
+        quint32         count;
+        quint32         blocks;
+    };
+
+    // unmapped when the last read holding it is done
+    struct SegmentMapping
+    {
+        explicit SegmentMapping(const QString &fileName) :
+            file(fileName),
+            data(nullptr),
+            size(0) {}
+        ~SegmentMapping()
+        {
+            if(data)
+                file.unmap(const_cast<uchar*>(data));
+        }
+
+        QFile           file;
+        const uchar     *data;
+        qint64          size;
+    };
+
+    struct SegmentIndex
+    {
+        SegmentIndex() :
+            scanned(0),
+            last(0),
+            size(-1),
+            used(0) {}
+
+        qint64              scanned;
+        QTBTimestamp        last;       // of the chunks indexed so far
+        QVector<ChunkEntry> chunks;
+        qint64              size;       // of the file, set by the recording for the segment it writes
+        QSharedPointer<SegmentMapping> mapping;
+        quint64             used;
+    };
+
+    void forgetReleasedSeries();
+    void encode(QTBDataArchiveStream *stream);
+    void write(QTBDataArchiveStream *stream);
+    bool openSegment(QTBDataArchiveStream *stream, QTBTimestamp first);
+    quint32 catalogId(QTBDataArchiveStream *stream, quint32 serieIndex);
+    QHash<QString, quint32> loadCatalog(const QString &sourcePath) const;
+    QStringList segments(const QString &sourcePath) const;
+    // under mIndexLock
+    QStringList segmentFiles(const QString &sourceName) const;
+    void indexSegment(SegmentIndex &index, const uchar *data, qint64 size) const;
+    const SegmentIndex *mapSegment(const QString &fileName) const;
+    void releaseMappings() const;
+    // every parameter for empty ids
+    void scan(const QString &sourceName, const QBitArray &ids,
+              QTBTimestamp begin, QTBTimestamp end,
+              const std::function<void(quint32, QTBTimestamp, QTBDataValue)> &func) const;
+
+    QTBDataManager *mDataManager;
+    QString mPath;
+    QMap<QString, QTBDataArchiveStream*> mStreams;
+    QThread *mThread;
+    QTimer *mRecordTimer;
+    QElapsedTimer mFlushClock;
+    QMutex mReleasedLock;
+    QVector<quint32> mReleasedSeries;
+
+    // segment files by source, listed again when the recording opens a new one
+    mutable QMutex mIndexLock;
+    mutable QHash<QString, QStringList> mSegmentFiles;
+    mutable QHash<QString, SegmentIndex> mSegmentIndexes;
+    mutable quint64 mReadCount;
+
+    // catalogs by source, loaded on first use then appended to by the recording
+    mutable QMutex mCatalogLock;
+    mutable QHash<QString, QHash<QString, quint32>> mCatalogs;
+};
+
+#endif // DATA_ARCHIVE_H
@@ -0,0 +1,362 @@
+#ifndef DATA_ARCHIVE_CODEC_H
+#define DATA_ARCHIVE_CODEC_H
+
+#include <QVector>
+#include <QtAlgorithms>
+#include "data_value.h"
+#include "data_timestamp.h"
+
+/* Bit stream of 64 bit words, most significant bit first. */
+class QTBArchiveBitWriter
+{
+public:
+    QTBArchiveBitWriter() :
+        mBits(0) {}
+
+    // keeps the allocation for the next chunk
+    void clear()
+    {
+        mWords.resize(0);
+        mBits = 0;
+    }
+
+    // writes the count (1 to 64) low bits of value
+    void write(quint64 value, int count)
+    {
+        if(count < 64)
+            value &= (Q_UINT64_C(1) << count) - 1;
+
+        const int used = int(mBits & 63);
+        if(used == 0)
+            mWords.append(0);
+
+        const int free = 64 - used;
+        if(count <= free) {
+            mWords.last() |= value << (free - count);
+        } else {
+            mWords.last() |= value >> (count - free);
+            mWords.append(value << (64 - (count - free)));
+        }
+        mBits += quint64(count);
+    }
+
+    const quint64 *words() const { return mWords.constData(); }
+    int wordCount() const { return mWords.size(); }
+
+private:
+    QVector<quint64> mWords;
+    quint64 mBits;
+};
+
+class QTBArchiveBitReader
+{
+public:
+    QTBArchiveBitReader(const quint64 *words, int wordCount) :
+        mWords(words),
+        mWordCount(wordCount),
+        mBits(0) {}
+
+    // reads count (1 to 64) bits, zeros past the end of the stream
+    quint64 read(int count)
+    {
+        const int index = int(mBits >> 6);
+        const int used = int(mBits & 63);
+        const int available = 64 - used;
+
+        quint64 value = (word(index) << used) >> (64 - count);
+        if(count > available)
+            value |= word(index + 1) >> (64 - (count - available));
+
+        mBits += quint64(count);
+        return value;
+    }
+
+    bool readBit() { return read(1) != 0; }
+
+private:
+    quint64 word(int index) const { return index < mWordCount ? mWords[index] : 0; }
+
+    const quint64 *mWords;
+    int mWordCount;
+    quint64 mBits;
+};
+
+/* Compression of the samples of one parameter, after the Gorilla paper:
+ * timestamps are stored as the difference between consecutive deltas,
+ * nothing but one bit for a steady rate; floats as the XOR with the
+ * previous value, integers as the zigzag difference with the previous
+ * value. A constant value costs one bit. The first sample is raw, each
+ * block decodes on its own. Arithmetic wraps, any input round trips. */
+class QTBArchiveCodec
+{
+public:
+    static quint64 zigzag(quint64 value) { return (value << 1) ^ quint64(qint64(value) >> 63); }
+    static quint64 unzigzag(quint64 value) { return (value >> 1) ^ (~(value & 1) + 1); }
+
+    // integer types as a 64 bit signed value, others as their raw bits
+    static qint64 integerValue(QTBDataValue::ValueType type, quint32 raw)
+    {
+        u_data data;
+        data.ui32 = raw;
+        switch(type) {
+        case QTBDataValue::TYPE_INT8: return data.s_i8.int8;
+        case QTBDataValue::TYPE_UINT8: return data.s_ui8.uint8;
+        case QTBDataValue::TYPE_INT16: return data.s_i16.int16;
+        case QTBDataValue::TYPE_UINT16: return data.s_ui16.uint16;
+        case QTBDataValue::TYPE_INT32: return data.i32;
+        default: return data.ui32;
+        }
+    }
+
+    // the padding of the small types is left to zero
+    static quint32 rawValue(QTBDataValue::ValueType type, qint64 value)
+    {
+        u_data data;
+        data.ui32 = 0;
+        switch(type) {
+        case QTBDataValue::TYPE_INT8: data.s_i8.int8 = qint8(value); break;
+        case QTBDataValue::TYPE_UINT8: data.s_ui8.uint8 = quint8(value); break;
+        case QTBDataValue::TYPE_INT16: data.s_i16.int16 = qint16(value); break;
+        case QTBDataValue::TYPE_UINT16: data.s_ui16.uint16 = quint16(value); break;
+        default: data.ui32 = quint32(value); break;
+        }
+        return data.ui32;
+    }
+};
+
+class QTBArchiveEncoder
+{
+public:
+    QTBArchiveEncoder() :
+        mType(QTBDataValue::TYPE_FLOAT),
+        mCount(0),
+        mFirst(0),
+        mLast(0),
+        mTimestamp(0),
+        mDelta(0),
+        mValue(0),
+        mLeading(-1),
+        mTrailing(0) {}
+
+    void clear()
+    {
+        mStream.clear();
+        mCount = 0;
+    }
+
+    void add(QTBDataValue::ValueType type, QTBTimestamp timestamp, quint32 raw)
+    {
+        if(mCount == 0) {
+            mType = type;
+            mFirst = mLast = timestamp;
+            mStream.write(quint64(timestamp), 64);
+            mStream.write(raw, 32);
+            mDelta = 0;
+            mLeading = -1;
+        } else {
+            writeTimestamp(timestamp);
+            if(mType == QTBDataValue::TYPE_FLOAT)
+                writeFloat(raw);
+            else
+                writeInteger(raw);
+            mFirst = qMin(mFirst, timestamp);
+            mLast = qMax(mLast, timestamp);
+        }
+
+        mTimestamp = timestamp;
+        mValue = raw;
+        mCount++;
+    }
+
+    QTBDataValue::ValueType type() const { return mType; }
+    quint32 count() const { return mCount; }
+    QTBTimestamp first() const { return mFirst; }
+    QTBTimestamp last() const { return mLast; }
+    const quint64 *words() const { return mStream.words(); }
+    int wordCount() const { return mStream.wordCount(); }
+
+private:
+    void writeTimestamp(QTBTimestamp timestamp)
+    {
+        const quint64 delta = quint64(timestamp) - quint64(mTimestamp);
+        const quint64 deltaOfDelta = QTBArchiveCodec::zigzag(delta - mDelta);
+        mDelta = delta;
+
+        // the ranges fit the jitter of a clock counted in ns
+        if(deltaOfDelta == 0) {
+            mStream.write(0, 1);
+        } else if(deltaOfDelta < (Q_UINT64_C(1) << 14)) {
+            mStream.write(0x2, 2);
+            mStream.write(deltaOfDelta, 14);
+        } else if(deltaOfDelta < (Q_UINT64_C(1) << 24)) {
+            mStream.write(0x6, 3);
+            mStream.write(deltaOfDelta, 24);
+        } else if(deltaOfDelta < (Q_UINT64_C(1) << 32)) {
+            mStream.write(0xE, 4);
+            mStream.write(deltaOfDelta, 32);
+        } else {
+            mStream.write(0xF, 4);
+            mStream.write(deltaOfDelta, 64);
+        }
+    }
+
+    void writeFloat(quint32 raw)
+    {
+        const quint32 xorValue = raw ^ mValue;
+        if(xorValue == 0) {
+            mStream.write(0, 1);
+            return;
+        }
+
+        const int leading = int(qCountLeadingZeroBits(xorValue));
+        const int trailing = int(qCountTrailingZeroBits(xorValue));
+        if(mLeading >= 0 && leading >= mLeading && trailing >= mTrailing) {
+            // the meaningful bits fit in the window of the previous value
+            mStream.write(0x2, 2);
+            mStream.write(xorValue >> mTrailing, 32 - mLeading - mTrailing);
+        } else {
+            const int meaningful = 32 - leading - trailing;
+            mStream.write(0x3, 2);
+            mStream.write(quint64(leading), 5);
+            mStream.write(quint64(meaningful - 1), 5);
+            mStream.write(xorValue >> trailing, meaningful);
+            mLeading = leading;
+            mTrailing = trailing;
+        }
+    }
+
+    void writeInteger(quint32 raw)
+    {
+        const qint64 value = QTBArchiveCodec::integerValue(mType, raw);
+        const qint64 previous = QTBArchiveCodec::integerValue(mType, mValue);
+        const quint64 delta = QTBArchiveCodec::zigzag(quint64(value) - quint64(previous));
+
+        if(delta == 0) {
+            mStream.write(0, 1);
+        } else if(delta < (1 << 4)) {
+            mStream.write(0x2, 2);
+            mStream.write(delta, 4);
+        } else if(delta < (1 << 8)) {
+            mStream.write(0x6, 3);
+            mStream.write(delta, 8);
+        } else if(delta < (1 << 16)) {
+            mStream.write(0xE, 4);
+            mStream.write(delta, 16);
+        } else {
+            mStream.write(0xF, 4);
+            mStream.write(raw, 32);
+        }
+    }
+
+    QTBArchiveBitWriter mStream;
+    QTBDataValue::ValueType mType;
+    quint32 mCount;
+    QTBTimestamp mFirst;
+    QTBTimestamp mLast;
+
+    QTBTimestamp mTimestamp;
+    quint64 mDelta;
+    quint32 mValue;
+    int mLeading;
+    int mTrailing;
+};
+
+class QTBArchiveDecoder
+{
+public:
+    QTBArchiveDecoder(QTBDataValue::ValueType type, const quint64 *words, int wordCount) :
+        mStream(words, wordCount),
+        mType(type),
+        mFirst(true),
+        mTimestamp(0),
+        mDelta(0),
+        mValue(0),
+        mLeading(0),
+        mTrailing(0) {}
+
+    // raw is the value as stored in QTBDataValue
+    void next(QTBTimestamp *timestamp, quint32 *raw)
+    {
+        if(mFirst) {
+            mFirst = false;
+            mTimestamp = QTBTimestamp(mStream.read(64));
+            mValue = quint32(mStream.read(32));
+        } else {
+            readTimestamp();
+            if(mType == QTBDataValue::TYPE_FLOAT)
+                readFloat();
+            else
+                readInteger();
+        }
+
+        *timestamp = mTimestamp;
+        *raw = mValue;
+    }
+
+private:
+    void readTimestamp()
+    {
+        quint64 deltaOfDelta = 0;
+        if(mStream.readBit()) {
+            if(!mStream.readBit())
+                deltaOfDelta = mStream.read(14);
+            else if(!mStream.readBit())
+                deltaOfDelta = mStream.read(24);
+            else if(!mStream.readBit())
+                deltaOfDelta = mStream.read(32);
+            else
+                deltaOfDelta = mStream.read(64);
+        }
+
+        mDelta += QTBArchiveCodec::unzigzag(deltaOfDelta);
+        mTimestamp = QTBTimestamp(quint64(mTimestamp) + mDelta);
+    }
+
+    void readFloat()
+    {
+        if(!mStream.readBit())
+            return;
+
+        if(mStream.readBit()) {
+            mLeading = int(mStream.read(5));
+            const int meaningful = int(mStream.read(5)) + 1;
+            mTrailing = 32 - mLeading - meaningful;
+        }
+        const quint32 xorValue = quint32(mStream.read(32 - mLeading - mTrailing)) << mTrailing;
+        mValue ^= xorValue;
+    }
+
+    void readInteger()
+    {
+        if(!mStream.readBit())
+            return;
+
+        quint64 delta;
+        if(!mStream.readBit()) {
+            delta = mStream.read(4);
+        } else if(!mStream.readBit()) {
+            delta = mStream.read(8);
+        } else if(!mStream.readBit()) {
+            delta = mStream.read(16);
+        } else {
+            mValue = quint32(mStream.read(32));
+            return;
+        }
+
+        const qint64 previous = QTBArchiveCodec::integerValue(mType, mValue);
+        const quint64 value = quint64(previous) + QTBArchiveCodec::unzigzag(delta);
+        mValue = QTBArchiveCodec::rawValue(mType, qint64(value));
+    }
+
+    QTBArchiveBitReader mStream;
+    QTBDataValue::ValueType mType;
+    bool mFirst;
+
+    QTBTimestamp mTimestamp;
+    quint64 mDelta;
+    quint32 mValue;
+    int mLeading;
+    int mTrailing;
+};
+
+#endif // DATA_ARCHIVE_CODEC_H
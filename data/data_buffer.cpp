@@ -1,43 +1,208 @@
 #include "data_buffer.h"
 
 QTBDataBuffer::QTBDataBuffer() :
-    mIndexCount(0)
+    mSlotCount(1),
+    mAllocatedBytes(0),
+    mMemoryCapReached(0)
 {
+    // slot 0 is reserved
+    mPages.append(new Slot[DATA_BUFFER_PAGE_SIZE]);
+}
+
+QTBDataBuffer::~QTBDataBuffer()
+{
+    for(Slot *page : mPages)
+        delete[] page;
+}
+
+quint32 QTBDataBuffer::allocateSerie(const QTBDataSerie &serie)
+{
+    // a new serie is refused once the memory cap is reached
+    if(!reserveBytes(serie.bytes()))
+        return 0;
 
+    quint32 slot;
+    if(!mFreeSlots.isEmpty()) {
+        slot = mFreeSlots.takeLast();
+    } else {
+        if(mSlotCount > DATA_BUFFER_SLOT_MASK) {
+            qWarning() << "Data buffer full," << mSlotCount << "series";
+            releaseBytes(serie.bytes());
+            return 0;
+        }
+        slot = mSlotCount++;
+        if(int(slot >> DATA_BUFFER_PAGE_BITS) == mPages.size())
+            mPages.append(new Slot[DATA_BUFFER_PAGE_SIZE]);
+    }
+
+    Slot &target = mPages.at(int(slot >> DATA_BUFFER_PAGE_BITS))[slot & (DATA_BUFFER_PAGE_SIZE - 1)];
+    target.serieIndex = ((target.generation & 0xFF) << DATA_BUFFER_SLOT_BITS) | slot;
+    target.serie = serie;
+    return target.serieIndex;
+}
+
+void QTBDataBuffer::freeSlot(Slot *slot)
+{
+    releaseBytes(slot->serie.bytes());
+    const quint32 index = serieSlot(slot->serieIndex);
+    slot->serieIndex = 0;
+    slot->generation++;
+    slot->serie = QTBDataSerie(1);
+    mFreeSlots.append(index);
 }
 
 quint32 QTBDataBuffer::createSerie()
 {
-    mIndexCount ++;
-    mDataSeries.insert(mIndexCount, QTBDataSerie());
-    return mIndexCount;
+    lockAllShards();
+    quint32 serieIndex = allocateSerie(QTBDataSerie());
+    unlockAllShards();
+    return serieIndex;
 }
 
-QTBDataSerie QTBDataBuffer::serie(quint32 serieIndex)
+QVector<quint32> QTBDataBuffer::createSeries(int count)
 {
-    if(mDataSeries.contains(serieIndex))
-        return mDataSeries.value(serieIndex);
-    
-    return QTBDataSerie();
+    QVector<quint32> serieIndexes;
+    serieIndexes.reserve(count);
+    lockAllShards();
+    QTBDataSerie serie;
+    for(int i = 0; i < count; i++) {
+        quint32 serieIndex = allocateSerie(serie);
+        if(serieIndex == 0)
+            break;
+        serieIndexes.append(serieIndex);
+    }
+    unlockAllShards();
+    return serieIndexes;
+}
+
+QTBDataSerieView QTBDataBuffer::serie(quint32 serieIndex)
+{
+    QMutex *lock = shardLock(serieIndex);
+    lock->lock();
+    Slot *slot = findSlot(serieIndex);
+    if(slot)
+        return QTBDataSerieView(lock, &slot->serie);
+
+    lock->unlock();
+    return QTBDataSerieView();
 }
 
 void QTBDataBuffer::removeSerie(quint32 serieIndex)
 {
-    if(mDataSeries.contains(serieIndex))
-        mDataSeries.remove(serieIndex);
+    lockAllShards();
+    Slot *slot = findSlot(serieIndex);
+    if(slot)
+        freeSlot(slot);
+    unlockAllShards();
 }
 
-void QTBDataBuffer::addSample(quint32 serieIndex, double timestamp, QTBDataValue value)
+void QTBDataBuffer::removeSeries(const QVector<quint32> &serieIndexes)
 {
-    if(mDataSeries.contains(serieIndex)) {
-        mDataSeries[serieIndex].addSample(timestamp, value);
+    lockAllShards();
+    for(quint32 serieIndex : serieIndexes) {
+        Slot *slot = findSlot(serieIndex);
+        if(slot)
+            freeSlot(slot);
     }
+    unlockAllShards();
+}
+
+void QTBDataBuffer::clearSeries()
+{
+    lockAllShards();
+    for(quint32 i = 1; i < mSlotCount; i++) {
+        Slot &slot = mPages.at(int(i >> DATA_BUFFER_PAGE_BITS))[i & (DATA_BUFFER_PAGE_SIZE - 1)];
+        if(slot.serieIndex)
+            slot.serie.clear();
+    }
+    unlockAllShards();
+}
+
+bool QTBDataBuffer::addSample(quint32 serieIndex, QTBTimestamp timestamp, QTBDataValue value)
+{
+    QMutexLocker locker(shardLock(serieIndex));
+    Slot *slot = findSlot(serieIndex);
+    if(slot) {
+        QTBDataSerie &serie = slot->serie;
+        if(value.mType != serie.valueType()) {
+            // the first sample gives the type of the serie, later ones are converted to it
+            if(serie.isEmpty()) {
+                qint64 previousBytes = serie.bytes();
+                serie.setValueType(value.mType);
+                mAllocatedBytes.fetchAndAddOrdered(qint64(serie.bytes()) - previousBytes);
+            } else {
+                value = value.toType(serie.valueType());
+            }
+        }
+        if(serie.needsGrowth(timestamp) && !mMemoryCapReached.loadAcquire()) {
+            int capacity = serie.grownCapacity();
+            if(reserveBytes(qint64(serie.plannedBytes(capacity)) - qint64(serie.bytes())))
+                serie.resize(capacity);
+        }
+        return serie.addSample(timestamp, value);
+    }
+    // the samples of a removed serie are ignored
+    return true;
+}
+
+void QTBDataBuffer::setSerieHistory(quint32 serieIndex, double durationSec, int maxSamples)
+{
+    QMutexLocker locker(shardLock(serieIndex));
+    Slot *slot = findSlot(serieIndex);
+    if(slot) {
+        const double previousDuration = slot->serie.historyDuration();
+        const int previousSize = slot->serie.historySize();
+        qint64 previousBytes = slot->serie.bytes();
+        slot->serie.setHistory(durationSec, maxSamples);
+        qint64 bytes = slot->serie.bytes();
+        if(bytes > previousBytes && !reserveBytes(bytes - previousBytes)) {
+            // over the cap, the previous retention stays
+            slot->serie.setHistory(previousDuration, previousSize);
+            bytes = slot->serie.bytes();
+            if(bytes > previousBytes)
+                mAllocatedBytes.fetchAndAddOrdered(bytes - previousBytes);
+        }
+        if(bytes < previousBytes)
+            releaseBytes(previousBytes - bytes);
+    }
+}
+
+bool QTBDataBuffer::reserveBytes(qint64 bytes)
+{
+    const qint64 cap = qint64(DATA_MEMORY_CAP_MB) * 1024 * 1024;
+    if(mAllocatedBytes.fetchAndAddOrdered(bytes) + bytes > cap) {
+        mAllocatedBytes.fetchAndAddOrdered(-bytes);
+        if(mMemoryCapReached.fetchAndStoreOrdered(1) == 0)
+            qWarning() << "Data history memory cap reached," << DATA_MEMORY_CAP_MB << "MB";
+        return false;
+    }
+    return true;
+}
+
+void QTBDataBuffer::releaseBytes(qint64 bytes)
+{
+    mAllocatedBytes.fetchAndAddOrdered(-bytes);
+    mMemoryCapReached.storeRelease(0);
 }
 
 QTBDataSample QTBDataBuffer::lastSample(quint32 serieIndex)
 {
-    if(mDataSeries.contains(serieIndex)) {
-        return *(mDataSeries.value(serieIndex).constEnd()-1);
+    QMutexLocker locker(shardLock(serieIndex));
+    Slot *slot = findSlot(serieIndex);
+    if(slot && !slot->serie.isEmpty()) {
+        return slot->serie.last();
     }
     return {};
 }
+
+void QTBDataBuffer::lockAllShards()
+{
+    for(int i=0; i<DATA_BUFFER_SHARD_COUNT; i++)
+        mShardLocks[i].lock();
+}
+
+void QTBDataBuffer::unlockAllShards()
+{
+    for(int i=DATA_BUFFER_SHARD_COUNT-1; i>=0; i--)
+        mShardLocks[i].unlock();
+}
@@ -1,23 +1,162 @@
 #ifndef DATABUFFER_H
 #define DATABUFFER_H
 
+#include <QMutex>
+#include <QAtomicInteger>
 #include "data_serie.h"
 
+#define DATA_BUFFER_SHARD_COUNT 64
+
+// a serie index is the slot of the serie in the table, with the generation
+// of the slot in the high bits
+#define DATA_BUFFER_SLOT_BITS 24
+#define DATA_BUFFER_SLOT_MASK ((1u << DATA_BUFFER_SLOT_BITS) - 1)
+#define DATA_BUFFER_PAGE_BITS 12
+#define DATA_BUFFER_PAGE_SIZE (1 << DATA_BUFFER_PAGE_BITS)
+
+/* Borrowed read access to a serie, no copy is made. The serie shard stays
+ * locked as long as the view lives: the data thread appending to any serie
+ * of that shard (about one in DATA_BUFFER_SHARD_COUNT) waits for it. Copy
+ * what is needed and release() the view at once, never hold two views (or
+ * call back into the data manager) at the same time. */
+class QTBDataSerieView
+{
+public:
+    typedef QTBDataSerie::const_iterator const_iterator;
+
+    QTBDataSerieView() :
+        mLock(nullptr),
+        mSerie(nullptr) {}
+
+    QTBDataSerieView(QMutex *lock, const QTBDataSerie *serie) :
+        mLock(lock),
+        mSerie(serie) {}
+
+    QTBDataSerieView(QTBDataSerieView &&other) :
+        mLock(other.mLock),
+        mSerie(other.mSerie)
+    {
+        other.mLock = nullptr;
+        other.mSerie = nullptr;
+    }
+
+    ~QTBDataSerieView() { release(); }
+
+    void release()
+    {
+        if(mLock)
+            mLock->unlock();
+        mLock = nullptr;
+        mSerie = nullptr;
+    }
+
+    bool isNull() const { return mSerie == nullptr; }
+    int size() const { return mSerie ? mSerie->size() : 0; }
+    bool isEmpty() const { return size() == 0; }
+
+    const_iterator constBegin() const { return mSerie ? mSerie->constBegin() : const_iterator(); }
+    const_iterator constEnd() const { return mSerie ? mSerie->constEnd() : const_iterator(); }
+
+    // cursor on the first sample stored after the one with the given counter
+    const_iterator findAfter(double counter) const { return mSerie ? mSerie->findBegin(counter + 1, false) : const_iterator(); }
+    // cursor on the first sample at or after the timestamp
+    const_iterator findTimestamp(QTBTimestamp timestamp) const { return mSerie ? mSerie->findTimestamp(timestamp) : const_iterator(); }
+
+    // bulk read of the samples from the cursor, values converted to double
+    void copy(const_iterator from, int count, QTBTimestamp *timestamps, double *values) const
+    {
+        if(mSerie)
+            mSerie->copy(from.index(), count, timestamps, values);
+    }
+
+    // downsampled [begin, end] on the given number of columns, see QTBDataSerie::envelope()
+    QVector<QTBDataEnvelope> envelope(QTBTimestamp begin, QTBTimestamp end, int columns) const
+    {
+        return mSerie ? mSerie->envelope(begin, end, columns) : QVector<QTBDataEnvelope>();
+    }
+
+private:
+    Q_DISABLE_COPY(QTBDataSerieView)
+
+    QMutex *mLock;
+    const QTBDataSerie *mSerie;
+};
+
+/* Series are spread over DATA_BUFFER_SHARD_COUNT locks so that the data
+ * thread appending to a serie and the GUI reading a serie of another shard
+ * don't wait on each other. A reader and the writer of the same shard do,
+ * for as long as the reader holds its view: readers copy and let go, they
+ * don't block the writer for longer than a copy. The lock is not avoided,
+ * a serie reallocates its ring when it grows. Creating or removing a serie
+ * takes every shard.
+ *
+ * The series live in a table of slots indexed by the low bits of the serie
+ * index, allocated by pages of DATA_BUFFER_PAGE_SIZE that never move: a
+ * lookup is a mask, a shift and a compare with the index stored in the
+ * slot. A removed slot is reused with its generation bumped, so the index
+ * it had before no longer matches and a stale index finds nothing. Slot 0
+ * is never used, 0 stays an invalid index. */
 class QTBDataBuffer
 {
 public:
     QTBDataBuffer();
+    ~QTBDataBuffer();
 
     quint32 createSerie();
-    QTBDataSerie serie(quint32 serieIndex);
+    QVector<quint32> createSeries(int count);
+    QTBDataSerieView serie(quint32 serieIndex);
     void removeSerie(quint32 serieIndex);
-    void addSample(quint32 serieIndex, double timestamp, QTBDataValue value);
+    void removeSeries(const QVector<quint32> &serieIndexes);
+    // empties every serie, the memory stays allocated
+    void clearSeries();
+    // false when the serie dropped the sample as too late, see QTBDataSerie::addSample()
+    bool addSample(quint32 serieIndex, QTBTimestamp timestamp, QTBDataValue value);
     QTBDataSample lastSample(quint32 serieIndex);
 
+    void setSerieHistory(quint32 serieIndex, double durationSec, int maxSamples);
+    qint64 allocatedBytes() const { return mAllocatedBytes.loadAcquire(); }
+
+    // position of the serie in the table, below slotCount()
+    static quint32 serieSlot(quint32 serieIndex) { return serieIndex & DATA_BUFFER_SLOT_MASK; }
+    quint32 slotCount() const { return mSlotCount; }
+
 private:
-    quint32 mIndexCount;
-    QHash<quint32, QTBDataSerie> mDataSeries;
-    bool mHistoryAutoResize;
+    struct Slot
+    {
+        // an empty serie until the slot is used
+        Slot() : serieIndex(0), generation(0), serie(1) {}
+
+        quint32 serieIndex;     // 0 when free
+        quint32 generation;
+        QTBDataSerie serie;
+    };
+
+    // the slot of serieIndex if it holds that serie, under its shard lock
+    Slot *findSlot(quint32 serieIndex) const
+    {
+        const quint32 slot = serieSlot(serieIndex);
+        if(slot >= mSlotCount || slot == 0)
+            return nullptr;
+        Slot *found = &mPages.at(int(slot >> DATA_BUFFER_PAGE_BITS))[slot & (DATA_BUFFER_PAGE_SIZE - 1)];
+        return found->serieIndex == serieIndex ? found : nullptr;
+    }
+    // a free slot or a new one, under every shard lock; 0 once the table is full
+    quint32 allocateSerie(const QTBDataSerie &serie);
+    void freeSlot(Slot *slot);
+
+    // the shard follows the slot, every generation of a slot shares its lock
+    QMutex *shardLock(quint32 serieIndex) { return &mShardLocks[serieSlot(serieIndex) % DATA_BUFFER_SHARD_COUNT]; }
+    void lockAllShards();
+    void unlockAllShards();
+    bool reserveBytes(qint64 bytes);
+    void releaseBytes(qint64 bytes);
+
+    QVector<Slot *> mPages;
+    quint32 mSlotCount;
+    QVector<quint32> mFreeSlots;
+    QMutex mShardLocks[DATA_BUFFER_SHARD_COUNT];
+    QAtomicInteger<qint64> mAllocatedBytes;
+    QAtomicInt mMemoryCapReached;
 };
 
 #endif // DATA_H
@@ -0,0 +1,199 @@
+#include "data_catalog.h"
+#include "data_buffer.h"
+
+QTBStringPool::QTBStringPool()
+{
+    mStrings.append(QString());
+    mReferences.append(0);
+}
+
+quint32 QTBStringPool::intern(const QString &string)
+{
+    if(string.isEmpty())
+        return 0;
+
+    QHash<QString, quint32>::const_iterator it = mHandles.constFind(string);
+    if(it != mHandles.constEnd()) {
+        mReferences[int(it.value())]++;
+        return it.value();
+    }
+
+    quint32 handle;
+    if(!mFreeHandles.isEmpty()) {
+        handle = mFreeHandles.takeLast();
+        mStrings[int(handle)] = string;
+        mReferences[int(handle)] = 1;
+    } else {
+        handle = quint32(mStrings.size());
+        mStrings.append(string);
+        mReferences.append(1);
+    }
+    mHandles.insert(string, handle);
+    return handle;
+}
+
+void QTBStringPool::release(quint32 handle)
+{
+    if(handle == 0 || --mReferences[int(handle)] > 0)
+        return;
+
+    mHandles.remove(mStrings.at(int(handle)));
+    mStrings[int(handle)] = QString();
+    mFreeHandles.append(handle);
+}
+
+void QTBParameterCatalog::reserve(int count)
+{
+    mLabelIndex.reserve(count);
+}
+
+int QTBParameterCatalog::slotOf(quint32 parameterId) const
+{
+    const int slot = int(QTBDataBuffer::serieSlot(parameterId));
+    return slot < mIds.size() && mIds.at(slot) == parameterId && parameterId ? slot : -1;
+}
+
+void QTBParameterCatalog::insert(const QSharedPointer<QTBParameter> &parameter)
+{
+    const quint32 parameterId = parameter->parameterId();
+    const int slot = int(QTBDataBuffer::serieSlot(parameterId));
+    if(slot >= mIds.size()) {
+        // series are allocated in increasing slots, grow like a vector does
+        const int size = qMax(slot + 1, mIds.size() * 2);
+        mIds.resize(size);
+        mParameters.resize(size);
+        mUnitHandles.resize(size);
+        mSourceHandles.resize(size);
+        mSourcePositions.resize(size);
+    }
+
+    const quint32 unit = mUnits.intern(parameter->unit());
+    const quint32 source = mSources.intern(parameter->sourceName());
+    parameter->setUnit(mUnits.string(unit));
+    parameter->setSourceName(mSources.string(source));
+
+    mIds[slot] = parameterId;
+    mParameters[slot] = parameter;
+    mUnitHandles[slot] = unit;
+    mSourceHandles[slot] = source;
+    mLabelIndex.insert(parameter->label(), parameterId);
+
+    if(int(source) >= mSourceMembers.size())
+        mSourceMembers.resize(int(source) + 1);
+    QVector<quint32> &members = mSourceMembers[int(source)];
+    if(members.isEmpty())
+        addSource(source);
+    mSourcePositions[slot] = members.size();
+    members.append(parameterId);
+}
+
+bool QTBParameterCatalog::remove(quint32 parameterId)
+{
+    const int slot = slotOf(parameterId);
+    if(slot < 0)
+        return false;
+
+    // the last member of the source takes the place of the removed one
+    const quint32 source = mSourceHandles.at(slot);
+    QVector<quint32> &members = mSourceMembers[int(source)];
+    const int position = mSourcePositions.at(slot);
+    const quint32 moved = members.last();
+    members[position] = moved;
+    mSourcePositions[int(QTBDataBuffer::serieSlot(moved))] = position;
+    members.removeLast();
+    if(members.isEmpty())
+        removeSource(source);
+
+    mLabelIndex.remove(mParameters.at(slot)->label());
+    mUnits.release(mUnitHandles.at(slot));
+    mSources.release(source);
+    mIds[slot] = 0;
+    mParameters[slot].reset();
+    return true;
+}
+
+void QTBParameterCatalog::addSource(quint32 source)
+{
+    const QString &name = mSources.string(source);
+    mPrefixIndex[QString()].append(source);
+    if(name.isEmpty())
+        return;
+
+    int separator = name.indexOf(QChar('/'));
+    while(separator >= 0) {
+        mPrefixIndex[name.left(separator)].append(source);
+        separator = name.indexOf(QChar('/'), separator + 1);
+    }
+    mPrefixIndex[name].append(source);
+}
+
+void QTBParameterCatalog::removeSource(quint32 source)
+{
+    QHash<QString, QVector<quint32>>::iterator it = mPrefixIndex.begin();
+    while(it != mPrefixIndex.end()) {
+        it.value().removeOne(source);
+        if(it.value().isEmpty())
+            it = mPrefixIndex.erase(it);
+        else
+            ++it;
+    }
+}
+
+QSharedPointer<QTBParameter> QTBParameterCatalog::parameter(quint32 parameterId) const
+{
+    const int slot = slotOf(parameterId);
+    return slot < 0 ? QSharedPointer<QTBParameter>() : mParameters.at(slot);
+}
+
+QString QTBParameterCatalog::label(quint32 parameterId) const
+{
+    const int slot = slotOf(parameterId);
+    return slot < 0 ? QString() : mParameters.at(slot)->label();
+}
+
+QString QTBParameterCatalog::unit(quint32 parameterId) const
+{
+    const int slot = slotOf(parameterId);
+    return slot < 0 ? QString() : mUnits.string(mUnitHandles.at(slot));
+}
+
+QString QTBParameterCatalog::sourceName(quint32 parameterId) const
+{
+    const int slot = slotOf(parameterId);
+    return slot < 0 ? QString() : mSources.string(mSourceHandles.at(slot));
+}
+
+QVector<quint32> QTBParameterCatalog::parameterIds() const
+{
+    QVector<quint32> parameterIds;
+    parameterIds.reserve(count());
+    for(quint32 parameterId : mIds) {
+        if(parameterId)
+            parameterIds.append(parameterId);
+    }
+    return parameterIds;
+}
+
+QStringList QTBParameterCatalog::sources(const QString &prefix) const
+{
+    QStringList names;
+    for(quint32 source : mPrefixIndex.value(prefix))
+        names.append(mSources.string(source));
+    return names;
+}
+
+QVector<quint32> QTBParameterCatalog::sourceParameters(const QString &sourceName) const
+{
+    const quint32 source = mSources.handle(sourceName);
+    if(int(source) >= mSourceMembers.size() || mSources.string(source) != sourceName)
+        return QVector<quint32>();
+    return mSourceMembers.at(int(source));
+}
+
+QVector<quint32> QTBParameterCatalog::parametersUnder(const QString &prefix) const
+{
+    QVector<quint32> parameterIds;
+    for(quint32 source : mPrefixIndex.value(prefix))
+        parameterIds += mSourceMembers.at(int(source));
+    return parameterIds;
+}
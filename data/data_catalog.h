@@ -0,0 +1,89 @@
+#ifndef DATACATALOG_H
+#define DATACATALOG_H
+
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+#include <QSharedPointer>
+#include "data_parameter.h"
+
+/* One instance of each string, shared by everyone who interned it. Handles
+ * are counted, a string is dropped with its last reference and its handle
+ * reused. Handle 0 is the empty string and is never dropped. */
+class QTBStringPool
+{
+public:
+    QTBStringPool();
+
+    quint32 intern(const QString &string);
+    void release(quint32 handle);
+
+    const QString &string(quint32 handle) const { return mStrings.at(int(handle)); }
+    // 0 when not in the pool, which is also the handle of the empty string
+    quint32 handle(const QString &string) const { return mHandles.value(string, 0); }
+
+private:
+    QVector<QString> mStrings;
+    QVector<quint32> mReferences;
+    QHash<QString, quint32> mHandles;
+    QVector<quint32> mFreeHandles;
+};
+
+/* The registered parameters, their metadata kept in arrays indexed by the
+ * slot of their serie (see QTBDataBuffer::serieSlot()). Units and source
+ * names are interned: the parameters of a source share one string, and the
+ * strings of a registered QTBParameter are replaced by the catalog ones.
+ * The label is held once, by the label index and the parameter alike.
+ * Source names are '/'-separated paths; every path prefix is indexed with
+ * the sources below it. Not thread safe, the data manager guards it. */
+class QTBParameterCatalog
+{
+public:
+    int count() const { return mLabelIndex.size(); }
+    void reserve(int count);
+
+    // the parameter id must be set, its label unknown to the catalog
+    void insert(const QSharedPointer<QTBParameter> &parameter);
+    bool remove(quint32 parameterId);
+
+    bool contains(const QString &label) const { return mLabelIndex.contains(label); }
+    // 0 for an unknown label
+    quint32 find(const QString &label) const { return mLabelIndex.value(label, 0); }
+    QSharedPointer<QTBParameter> parameter(quint32 parameterId) const;
+
+    QString label(quint32 parameterId) const;
+    QString unit(quint32 parameterId) const;
+    QString sourceName(quint32 parameterId) const;
+
+    const QHash<QString, quint32> &labelIndex() const { return mLabelIndex; }
+    QVector<quint32> parameterIds() const;
+
+    // the source names at or below a path, all of them for an empty prefix
+    QStringList sources(const QString &prefix = QString()) const;
+    QVector<quint32> sourceParameters(const QString &sourceName) const;
+    // the parameters of every source at or below a path
+    QVector<quint32> parametersUnder(const QString &prefix) const;
+
+private:
+    int slotOf(quint32 parameterId) const;
+    void addSource(quint32 source);
+    void removeSource(quint32 source);
+
+    QHash<QString, quint32> mLabelIndex;
+    QTBStringPool mUnits;
+    QTBStringPool mSources;
+
+    // by slot, mIds is 0 for a free slot
+    QVector<quint32> mIds;
+    QVector<QSharedPointer<QTBParameter>> mParameters;
+    QVector<quint32> mUnitHandles;
+    QVector<quint32> mSourceHandles;
+    QVector<int> mSourcePositions;      // in the members of the source
+
+    // by source handle
+    QVector<QVector<quint32>> mSourceMembers;
+    // every path prefix of the sources, and the empty one
+    QHash<QString, QVector<quint32>> mPrefixIndex;
+};
+
+#endif // DATACATALOG_H
@@ -3,5 +3,7 @@
 
 #define DEFAULT_DATA_PERIOD_MS_MAX 20
 #define DEFAULT_DATA_HISTORY_SEC 60
+#define DEFAULT_DATA_HISTORY_SAMPLES 262144
+#define DATA_MEMORY_CAP_MB 1024
 
 #endif // DATA_COMMON_H
@@ -0,0 +1,313 @@
+#include "data_export.h"
+#include "data_manager.h"
+#include <QThread>
+#include <limits>
+
+QTBDataExport::QTBDataExport(QTBDataManager *dataManager, const QTBDataExportSettings &settings) :
+    QObject(nullptr),
+    mDataManager(dataManager),
+    mSettings(settings),
+    mCanceled(0),
+    mRows(0),
+    mGroupRows(0)
+{
+}
+
+void QTBDataExport::start()
+{
+    QMetaObject::invokeMethod(this, "run", Qt::QueuedConnection);
+}
+
+void QTBDataExport::cancel()
+{
+    mCanceled.storeRelease(1);
+}
+
+bool QTBDataExport::canceled() const
+{
+    return mCanceled.loadAcquire() || QThread::currentThread()->isInterruptionRequested();
+}
+
+void QTBDataExport::run()
+{
+    if(mSettings.labels.isEmpty() || mSettings.end < mSettings.begin) {
+        emit finished(false, tr("Nothing to export"));
+        return;
+    }
+
+    QTBDataArchive *archive = mDataManager->archive();
+    if(mSettings.source == QTBDataExportSettings::esArchive && !archive) {
+        emit finished(false, tr("No archive to export from"));
+        return;
+    }
+
+    QHash<QString, quint32> parameterLabels = mDataManager->parameterLabels();
+    mColumns.resize(mSettings.labels.count());
+    for(int i = 0; i < mSettings.labels.count(); i++) {
+        Column &column = mColumns[i];
+        column.label = mSettings.labels.at(i);
+        column.parameterId = parameterLabels.value(column.label, 0);
+        column.position = 0;
+    }
+
+    // archived labels are found once in the catalog of their source, the columns of a source
+    // are then read together
+    mArchiveSources.clear();
+    if(mSettings.source == QTBDataExportSettings::esArchive) {
+        QHash<QString, int> columnIndexes;
+        for(int i = 0; i < mColumns.count(); i++)
+            columnIndexes.insert(mColumns.at(i).label, i);
+
+        for(const QString &sourceName : archive->sources()) {
+            const QHash<QString, quint32> catalog = archive->catalog(sourceName);
+            ArchiveSource source;
+            source.name = sourceName;
+            for(QHash<QString, quint32>::const_iterator it = catalog.constBegin(); it != catalog.constEnd(); ++it) {
+                QHash<QString, int>::iterator column = columnIndexes.find(it.key());
+                if(column == columnIndexes.end())
+                    continue;
+                if(int(it.value()) >= source.ids.size())
+                    source.ids.resize(int(it.value()) + 1);
+                source.ids.setBit(int(it.value()));
+                source.columns.insert(it.value(), column.value());
+                // a label archived by several sources is read from one
+                columnIndexes.erase(column);
+            }
+            if(!source.columns.isEmpty())
+                mArchiveSources.append(source);
+        }
+    }
+
+    if(!openFile()) {
+        emit finished(false, tr("Can't open %1").arg(mSettings.fileName));
+        return;
+    }
+
+    const QTBTimestamp window = (mSettings.source == QTBDataExportSettings::esArchive ?
+                                     EXPORT_ARCHIVE_WINDOW_MS : EXPORT_WINDOW_MS) * TIMESTAMP_NS_PER_MSEC;
+    const double range = double(mSettings.end - mSettings.begin) + 1.0;
+    int percent = -1;
+    bool success = true;
+    for(QTBTimestamp begin = mSettings.begin; begin <= mSettings.end; begin += window) {
+        if(canceled()) {
+            success = false;
+            break;
+        }
+
+        const QTBTimestamp end = qMin(mSettings.end, begin + window - 1);
+        if(!readWindow(begin, end) || !mergeWindow()) {
+            success = false;
+            break;
+        }
+
+        const int newPercent = int(100.0 * double(end - mSettings.begin + 1) / range);
+        if(newPercent != percent) {
+            percent = newPercent;
+            emit progress(percent);
+        }
+    }
+
+    if(!closeFile())
+        success = false;
+
+    if(success) {
+        emit finished(true, tr("%1 rows exported to %2").arg(mRows).arg(mSettings.fileName));
+    } else {
+        mFile.remove();
+        emit finished(false, canceled() ? tr("Export canceled") : tr("Can't write %1").arg(mSettings.fileName));
+    }
+}
+
+bool QTBDataExport::openFile()
+{
+    mFile.setFileName(mSettings.fileName);
+    if(!mFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    mRows = 0;
+    mBytes.clear();
+    mBytes.reserve(EXPORT_WRITE_BYTES + 4096);
+
+    if(mSettings.format == QTBDataExportSettings::efCsv) {
+        mBytes.append("time");
+        for(const Column &column : mColumns) {
+            mBytes.append(',');
+            mBytes.append(column.label.toUtf8());
+        }
+        mBytes.append('\n');
+    } else {
+        const quint32 header[4] = { EXPORT_BINARY_MAGIC, EXPORT_BINARY_VERSION, quint32(mColumns.count()), 0 };
+        const qint64 rows = 0;  // written on close
+        mBytes.append(reinterpret_cast<const char*>(header), sizeof(header));
+        mBytes.append(reinterpret_cast<const char*>(&rows), sizeof(rows));
+        for(const Column &column : mColumns) {
+            const QByteArray label = column.label.toUtf8();
+            const quint32 size = quint32(label.size());
+            mBytes.append(reinterpret_cast<const char*>(&size), sizeof(size));
+            mBytes.append(label);
+        }
+
+        mGroupTimestamps.resize(EXPORT_CHUNK_ROWS);
+        mGroupValues.resize(EXPORT_CHUNK_ROWS * mColumns.count());
+        mGroupRows = 0;
+    }
+    return writeBytes(true);
+}
+
+bool QTBDataExport::closeFile()
+{
+    bool success = true;
+    if(mSettings.format == QTBDataExportSettings::efBinary) {
+        success = writeGroup() && writeBytes(true);
+        // the row count of the header
+        if(success && mFile.seek(4 * sizeof(quint32)))
+            success = mFile.write(reinterpret_cast<const char*>(&mRows), sizeof(mRows)) == sizeof(mRows);
+    } else {
+        success = writeBytes(true);
+    }
+    mFile.close();
+    return success;
+}
+
+bool QTBDataExport::readWindow(QTBTimestamp begin, QTBTimestamp end)
+{
+    for(Column &column : mColumns) {
+        column.timestamps.resize(0);
+        column.values.resize(0);
+        column.position = 0;
+    }
+
+    if(mSettings.source == QTBDataExportSettings::esArchive) {
+        for(const ArchiveSource &source : mArchiveSources) {
+            readArchive(source, begin, end);
+            if(canceled())
+                return false;
+        }
+        return true;
+    }
+
+    for(Column &column : mColumns) {
+        readBuffer(column, begin, end);
+        if(canceled())
+            return false;
+    }
+    return true;
+}
+
+void QTBDataExport::readBuffer(Column &column, QTBTimestamp begin, QTBTimestamp end)
+{
+    if(column.parameterId == 0)
+        return;
+
+    // bounded copies, the serie is only locked for one of them at a time
+    QTBTimestamp from = begin;
+    forever {
+        QTBDataSerieView serie = mDataManager->dataSerie(column.parameterId);
+        QTBDataSerieView::const_iterator first = serie.findTimestamp(from);
+        QTBDataSerieView::const_iterator last = serie.findTimestamp(end + 1);
+        const int count = qMin(int(last - first), EXPORT_CHUNK_SAMPLES);
+        if(count <= 0)
+            return;
+
+        const int size = column.timestamps.size();
+        column.timestamps.resize(size + count);
+        column.values.resize(size + count);
+        serie.copy(first, count, column.timestamps.data() + size, column.values.data() + size);
+        serie.release();
+
+        if(count < EXPORT_CHUNK_SAMPLES)
+            return;
+        from = column.timestamps.last() + 1;
+    }
+}
+
+void QTBDataExport::readArchive(const ArchiveSource &source, QTBTimestamp begin, QTBTimestamp end)
+{
+    QVector<Column> &columns = mColumns;
+    mDataManager->archive()->read(source.name, source.ids, begin, end,
+                                  [&columns, &source](quint32 id, QTBTimestamp timestamp, QTBDataValue value) {
+        Column &column = columns[source.columns.value(id)];
+        column.timestamps.append(timestamp);
+        column.values.append(value.toDouble());
+    });
+}
+
+bool QTBDataExport::mergeWindow()
+{
+    // k-way merge of the columns on their timestamps
+    const QTBTimestamp none = std::numeric_limits<QTBTimestamp>::max();
+    forever {
+        QTBTimestamp timestamp = none;
+        for(const Column &column : mColumns) {
+            if(column.position < column.timestamps.size())
+                timestamp = qMin(timestamp, column.timestamps.at(column.position));
+        }
+        if(timestamp == none)
+            return true;
+
+        if(!writeRow(timestamp))
+            return false;
+    }
+}
+
+bool QTBDataExport::writeRow(QTBTimestamp timestamp)
+{
+    mRows++;
+
+    if(mSettings.format == QTBDataExportSettings::efBinary) {
+        const int columns = mColumns.count();
+        mGroupTimestamps[mGroupRows] = timestamp;
+        for(int i = 0; i < columns; i++) {
+            Column &column = mColumns[i];
+            double value = qQNaN();
+            if(column.position < column.timestamps.size() && column.timestamps.at(column.position) == timestamp)
+                value = column.values.at(column.position++);
+            mGroupValues[i * EXPORT_CHUNK_ROWS + mGroupRows] = value;
+        }
+        mGroupRows++;
+        return mGroupRows < EXPORT_CHUNK_ROWS || writeGroup();
+    }
+
+    // seconds since epoch, the nanoseconds are kept
+    qint64 seconds = timestamp / TIMESTAMP_NS_PER_SEC;
+    qint64 nanoseconds = timestamp % TIMESTAMP_NS_PER_SEC;
+    if(nanoseconds < 0) {
+        seconds--;
+        nanoseconds += TIMESTAMP_NS_PER_SEC;
+    }
+    mBytes.append(QByteArray::number(seconds));
+    mBytes.append('.');
+    mBytes.append(QByteArray::number(nanoseconds).rightJustified(9, '0'));
+
+    for(Column &column : mColumns) {
+        mBytes.append(',');
+        if(column.position < column.timestamps.size() && column.timestamps.at(column.position) == timestamp)
+            mBytes.append(QByteArray::number(column.values.at(column.position++), 'g', 10));
+    }
+    mBytes.append('\n');
+    return writeBytes(false);
+}
+
+bool QTBDataExport::writeGroup()
+{
+    if(mGroupRows == 0)
+        return true;
+
+    const quint32 header[2] = { EXPORT_GROUP_MAGIC, quint32(mGroupRows) };
+    mBytes.append(reinterpret_cast<const char*>(header), sizeof(header));
+    mBytes.append(reinterpret_cast<const char*>(mGroupTimestamps.constData()), mGroupRows * int(sizeof(QTBTimestamp)));
+    for(int i = 0; i < mColumns.count(); i++)
+        mBytes.append(reinterpret_cast<const char*>(mGroupValues.constData() + i * EXPORT_CHUNK_ROWS), mGroupRows * int(sizeof(double)));
+    mGroupRows = 0;
+    return writeBytes(true);
+}
+
+bool QTBDataExport::writeBytes(bool force)
+{
+    if(mBytes.isEmpty() || (!force && mBytes.size() < EXPORT_WRITE_BYTES))
+        return true;
+
+    const bool success = mFile.write(mBytes) == mBytes.size();
+    mBytes.resize(0);
+    return success;
+}
@@ -0,0 +1,131 @@
+#ifndef DATA_EXPORT_H
+#define DATA_EXPORT_H
+
+#include <QObject>
+#include <QFile>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QBitArray>
+#include <QAtomicInt>
+#include "data_timestamp.h"
+
+#define EXPORT_WINDOW_MS 1000
+// archive chunks hold a second each, wider windows decode the chunks across their bounds less often
+#define EXPORT_ARCHIVE_WINDOW_MS 10000
+#define EXPORT_CHUNK_SAMPLES 65536
+#define EXPORT_CHUNK_ROWS 65536
+#define EXPORT_WRITE_BYTES (4 * 1024 * 1024)
+#define EXPORT_BINARY_MAGIC 0x58425451 // "QTBX"
+#define EXPORT_GROUP_MAGIC 0x47425451 // "QTBG"
+#define EXPORT_BINARY_VERSION 1
+
+class QTBDataManager;
+
+struct QTBDataExportSettings
+{
+    enum Format {
+        efCsv,
+        efBinary
+    };
+
+    enum Source {
+        esBuffer,
+        esArchive
+    };
+
+    QTBDataExportSettings() :
+        format(efCsv),
+        source(esBuffer),
+        begin(0),
+        end(0) {}
+
+    QString         fileName;
+    Format          format;
+    Source          source;
+    QStringList     labels;
+    QTBTimestamp    begin;
+    QTBTimestamp    end;
+};
+
+/* Writes [begin, end] of a set of parameters to a file, one row per
+ * timestamp and one column per parameter, empty where a parameter has no
+ * sample at that time. The range is read by windows: from the data buffer
+ * by bounded copies, each holding the lock of one serie for a moment only,
+ * or from the archive, with one pass per archived source for all of its
+ * columns. Each window is merged on the timestamps and written before the
+ * next one is read.
+ * Binary format, native byte order:
+ *   header     quint32 magic, version, columns, reserved; qint64 rows
+ *   labels     per column, quint32 size and UTF-8 bytes
+ *   groups     quint32 magic, rows; qint64 timestamps[rows];
+ *              then per column double values[rows], NaN where empty
+ * Runs on the export thread of the data manager, see QTBDataManager::exportData(). */
+class QTBDataExport : public QObject
+{
+    Q_OBJECT
+public:
+    QTBDataExport(QTBDataManager *dataManager, const QTBDataExportSettings &settings);
+
+    QTBDataExportSettings settings() const { return mSettings; }
+
+    // queued to the export thread
+    void start();
+
+public slots:
+    // thread safe
+    void cancel();
+
+signals:
+    void progress(int percent);
+    void finished(bool success, const QString &message);
+
+private slots:
+    void run();
+
+private:
+    struct Column
+    {
+        QString                 label;
+        quint32                 parameterId;
+        QVector<QTBTimestamp>   timestamps;
+        QVector<double>         values;
+        int                     position;
+    };
+
+    // the columns archived by one source, by their catalog id
+    struct ArchiveSource
+    {
+        QString                 name;
+        QBitArray               ids;
+        QHash<quint32, int>     columns;
+    };
+
+    bool openFile();
+    bool readWindow(QTBTimestamp begin, QTBTimestamp end);
+    void readBuffer(Column &column, QTBTimestamp begin, QTBTimestamp end);
+    void readArchive(const ArchiveSource &source, QTBTimestamp begin, QTBTimestamp end);
+    bool mergeWindow();
+    bool writeRow(QTBTimestamp timestamp);
+    bool writeGroup();
+    bool writeBytes(bool force);
+    bool closeFile();
+    bool canceled() const;
+
+    QTBDataManager *mDataManager;
+    QTBDataExportSettings mSettings;
+    QAtomicInt mCanceled;
+
+    QFile mFile;
+    QVector<Column> mColumns;
+    QVector<ArchiveSource> mArchiveSources;
+    qint64 mRows;
+
+    // pending output
+    QByteArray mBytes;
+    QVector<QTBTimestamp> mGroupTimestamps;
+    QVector<double> mGroupValues;   // column major
+    int mGroupRows;
+};
+
+#endif // DATA_EXPORT_H
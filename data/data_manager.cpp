@@ -1,19 +1,38 @@
 #include "data_manager.h"
 #include "data_source_interface.h"
-
-QTBDataManager::QTBDataManager(QObject *parent) : QObject(parent)
+#include <QSettings>
+#include <QSet>
+
+QTBDataManager::QTBDataManager(QObject *parent) : QObject(parent),
+    mArchive(nullptr),
+    mReplay(nullptr),
+    mResolver(nullptr),
+    mReplaying(0),
+    mResetPending(0)
 {
     mDataBuffer = QSharedPointer<QTBDataBuffer>(new QTBDataBuffer());
+
+    QSettings settings(QApplication::applicationDirPath() + QDir::separator() + QApplication::applicationName() + QString(".ini"),
+                       QSettings::IniFormat);
+    QString archiveDir = settings.value(QString("ArchiveDir")).toString();
+    if(!archiveDir.isEmpty()) {
+        mArchive = new QTBDataArchive(this, archiveDir, this);
+        mReplay = new QTBDataReplay(this, mArchive, this);
+    }
+
     mParametersTimer = new QTimer(this);
     mParametersTimer->setSingleShot(true);
     mParametersTimer->setInterval(TEMPO_MS_PARAM_UPDATE);
     connect(mParametersTimer, SIGNAL(timeout()), this, SIGNAL(parametersUpdated()));
     connect(this, SIGNAL(newParameters()), mParametersTimer, SLOT(start()));
+    mResolver = new QTBParameterResolver(this, this);
     loadDataSources();
+    if(mArchive)
+        mArchive->start();
 
     mThread = new QThread(this);
     mDataTimer = new QTimer(nullptr); // _not_ this!
-    mDataTimer->setInterval(100);
+    mDataTimer->setInterval(DATA_MERGE_PERIOD_MS);
     mDataTimer->setTimerType(Qt::PreciseTimer);
     mDataTimer->moveToThread(mThread);
     connect(mDataTimer, SIGNAL(timeout()), SLOT(updateData()), Qt::DirectConnection);
@@ -21,10 +40,18 @@ QTBDataManager::QTBDataManager(QObject *parent) : QObject(parent)
     connect(mThread, SIGNAL (finished()), mThread, SLOT (deleteLater()));
     mDataTimer->connect(mThread, SIGNAL(started()), SLOT(start()));
     mThread->start();
+
+    mExportThread = new QThread(this);
+    mExportThread->start();
 }
 
 QTBDataManager::~QTBDataManager()
 {
+    // a running export stops at its next window
+    mExportThread->requestInterruption();
+    mExportThread->quit();
+    mExportThread->wait();
+
     mThread->quit();
     mThread->wait();
 
@@ -32,20 +59,29 @@ QTBDataManager::~QTBDataManager()
     for (iter_datasource = mDataSources.constBegin(); iter_datasource != mDataSources.constEnd(); ++iter_datasource)
         iter_datasource.value()->stop();
 
+    // records what the sources pushed before stopping
+    if(mArchive)
+        mArchive->stop();
+
     qDeleteAll(mDataSources);
 }
 
 bool QTBDataManager::registerParameter(const QSharedPointer<QTBParameter>& param)
 {
     if(param) {
-        QMutexLocker locker(&mMutex);
-        if(!mParameterLabels.contains(param->label())) {
+        QWriteLocker locker(&mParametersLock);
+        if(!mCatalog.contains(param->label())) {
             quint32 parameterId = mDataBuffer->createSerie();
+            if(parameterId == 0) {
+                qWarning() << "Data buffer refused parameter" << param->label();
+                return false;
+            }
+            mDataBuffer->setSerieHistory(parameterId, param->historyDuration(), param->historySize());
             param->setParameterId(parameterId);
-            mParameters.insert(parameterId, param);
-            mParameterLabels.insert(param->label(), parameterId);
-        mParameterSourceNames.insert(param->label(), param->sourceName());
+            mCatalog.insert(param);
+            locker.unlock();
 
+            emit parametersChanged(QVector<quint32>() << parameterId, QVector<quint32>());
             emit newParameters();
             return true;
         }
@@ -54,134 +90,268 @@ bool QTBDataManager::registerParameter(const QSharedPointer<QTBParameter>& param
     return false;
 }
 
+int QTBDataManager::registerParameters(const QList<QSharedPointer<QTBParameter>>& params)
+{
+    QVector<quint32> added;
+    {
+        QWriteLocker locker(&mParametersLock);
+
+        // the new labels first, their series are then allocated in one pass
+        QList<QSharedPointer<QTBParameter>> newParams;
+        QSet<QString> newLabels;
+        for(const QSharedPointer<QTBParameter> &param : params) {
+            if(param && !mCatalog.contains(param->label()) && !newLabels.contains(param->label())) {
+                newLabels.insert(param->label());
+                newParams.append(param);
+            }
+        }
+        if(newParams.isEmpty())
+            return 0;
+
+        const int count = newParams.count();
+        mCatalog.reserve(mCatalog.count() + count);
+        added.reserve(count);
+
+        const QVector<quint32> parameterIds = mDataBuffer->createSeries(count);
+        for(int i = 0; i < parameterIds.count(); i++) {
+            const QSharedPointer<QTBParameter> &param = newParams.at(i);
+            const quint32 parameterId = parameterIds.at(i);
+            mDataBuffer->setSerieHistory(parameterId, param->historyDuration(), param->historySize());
+            param->setParameterId(parameterId);
+            mCatalog.insert(param);
+            added.append(parameterId);
+        }
+
+        // the buffer is full or over its memory cap: the others are not registered
+        if(parameterIds.count() < count)
+            qWarning() << "Data buffer refused" << count - parameterIds.count() << "of" << count << "parameters";
+    }
+    if(added.isEmpty())
+        return 0;
 
-void QTBDataManager::unregisterParameter(const QSharedPointer<QTBParameter>& param)
+    emit parametersChanged(added, QVector<quint32>());
+    emit newParameters();
+    return added.count();
+}
+
+void QTBDataManager::unregisterParameters(const QVector<quint32>& parameterIds)
 {
-    if(param) {
-        QMutexLocker locker(&mMutex);
-        mDataBuffer->removeSerie(param->parameterId());
-        mParameters.remove(param->parameterId());
-        mParameterLabels.remove(param->label());
-        mParameterSourceNames.remove(param->label());
+    QVector<quint32> removed;
+    {
+        QWriteLocker locker(&mParametersLock);
+        removed.reserve(parameterIds.count());
+        for(quint32 parameterId : parameterIds) {
+            if(mCatalog.remove(parameterId))
+                removed.append(parameterId);
+        }
+        mDataBuffer->removeSeries(removed);
+    }
 
+    if(!removed.isEmpty()) {
+        if(mArchive)
+            mArchive->releaseSeries(removed);
+        emit parametersChanged(QVector<quint32>(), removed);
         emit newParameters();
     }
 }
 
+
+void QTBDataManager::unregisterParameter(const QSharedPointer<QTBParameter>& param)
+{
+    if(param)
+        unregisterParameter(param->parameterId());
+}
+
 void QTBDataManager::unregisterParameter(quint32 parameterId)
 {
-    QMutexLocker locker(&mMutex);
-    if(mParameters.contains(parameterId)) {
-        QString label = mParameters.value(parameterId)->label();
+    QWriteLocker locker(&mParametersLock);
+    if(mCatalog.remove(parameterId)) {
         mDataBuffer->removeSerie(parameterId);
-        mParameters.remove(parameterId);
-        mParameterLabels.remove(label);
-        mParameterSourceNames.remove(label);
+        locker.unlock();
 
+        if(mArchive)
+            mArchive->releaseSeries(QVector<quint32>() << parameterId);
+        emit parametersChanged(QVector<quint32>(), QVector<quint32>() << parameterId);
         emit newParameters();
     }
 }
 
 void QTBDataManager::unregisterParameter(const QString& label)
 {
-    QMutexLocker locker(&mMutex);
-    if(mParameterLabels.contains(label)) {
-        quint32 parameterId = mParameterLabels.value(label);
-        if(mParameters.contains(parameterId)) {
-            QString label = mParameters.value(parameterId)->label();
-            mDataBuffer->removeSerie(parameterId);
-            mParameters.remove(parameterId);
-            mParameterLabels.remove(label);
-            mParameterSourceNames.remove(label);
-
-            emit newParameters();
-        }
+    quint32 parameterId;
+    {
+        QReadLocker locker(&mParametersLock);
+        parameterId = mCatalog.find(label);
     }
+    if(parameterId)
+        unregisterParameter(parameterId);
 }
 
 QSharedPointer<QTBParameter> QTBDataManager::parameter(quint32 parameterId)
 {
-    QMutexLocker locker(&mMutex);
-    QSharedPointer<QTBParameter> param = nullptr;
-    if(mParameters.contains(parameterId)) {
-        return mParameters.value(parameterId);
-    }
-    return param;
+    QReadLocker locker(&mParametersLock);
+    return mCatalog.parameter(parameterId);
 }
 
 QSharedPointer<QTBParameter> QTBDataManager::parameter(const QString& label)
 {
-    QMutexLocker locker(&mMutex);
-    QSharedPointer<QTBParameter> param = nullptr;
-    if(mParameterLabels.contains(label)) {
-        quint32 parameterId = mParameterLabels.value(label);
-        if(mParameters.contains(parameterId)) {
-            return mParameters.value(parameterId);
-        }
-    }
-    return param;
+    QReadLocker locker(&mParametersLock);
+    return mCatalog.parameter(mCatalog.find(label));
 }
 
 QHash<quint32, QSharedPointer<QTBParameter>> QTBDataManager::parameters() const
 {
-    QMutexLocker locker(&mMutex);
-    return mParameters;
+    QReadLocker locker(&mParametersLock);
+    QHash<quint32, QSharedPointer<QTBParameter>> parameters;
+    parameters.reserve(mCatalog.count());
+    for(quint32 parameterId : mCatalog.parameterIds())
+        parameters.insert(parameterId, mCatalog.parameter(parameterId));
+    return parameters;
 }
 
 QHash<QString, quint32> QTBDataManager::parameterLabels() const
 {
-    QMutexLocker locker(&mMutex);
-    return mParameterLabels;
+    QReadLocker locker(&mParametersLock);
+    return mCatalog.labelIndex();
 }
 
-void QTBDataManager::addSampleUnsafe(quint32 serieIndex, double timestamp, QTBDataValue value)
+QStringList QTBDataManager::parameterSources(const QString &prefix) const
 {
-    mDataBuffer->addSample(serieIndex, timestamp, value);
+    QReadLocker locker(&mParametersLock);
+    return mCatalog.sources(prefix);
 }
 
-void QTBDataManager::addSample(quint32 serieIndex, double timestamp, QTBDataValue value)
+QStringList QTBDataManager::sourceLabels(const QString &sourceName) const
 {
-    QMutexLocker locker(&mMutex);
-    mDataBuffer->addSample(serieIndex, timestamp, value);
+    QReadLocker locker(&mParametersLock);
+    QStringList labels;
+    for(quint32 parameterId : mCatalog.sourceParameters(sourceName))
+        labels.append(mCatalog.label(parameterId));
+    return labels;
+}
+
+bool QTBDataManager::addSample(quint32 serieIndex, QTBTimestamp timestamp, QTBDataValue value)
+{
+    const bool stored = mDataBuffer->addSample(serieIndex, timestamp, value);
+    mSnapshot.markChanged(serieIndex);
+    return stored;
 }
 
 QTBDataSample QTBDataManager::lastSample(quint32 serieIndex)
 {
-    QMutexLocker locker(&mMutex);
     return mDataBuffer->lastSample(serieIndex);
 }
 
-QTBDataSample QTBDataManager::lastSampleUnsafe(quint32 serieIndex)
+const QTBDataSnapshotTable *QTBDataManager::latestSamples()
 {
-    return mDataBuffer->lastSample(serieIndex);
+    return mSnapshot.acquire();
 }
 
-QTBDataSerie QTBDataManager::dataSerie(quint32 serieIndex)
+QTBDataSerieView QTBDataManager::dataSerie(quint32 serieIndex)
 {
-    QMutexLocker locker(&mMutex);
     return mDataBuffer->serie(serieIndex);
 }
 
-QTBDataSerie QTBDataManager::dataSerieUnsafe(quint32 serieIndex)
+QVector<QTBDataEnvelope> QTBDataManager::dataEnvelope(quint32 serieIndex, QTBTimestamp begin, QTBTimestamp end, int columns)
 {
-    return mDataBuffer->serie(serieIndex);
+    return mDataBuffer->serie(serieIndex).envelope(begin, end, columns);
+}
+
+void QTBDataManager::setHistory(quint32 parameterId, double durationSec)
+{
+    // the history displayed never goes below the one requested by the source
+    QSharedPointer<QTBParameter> param = parameter(parameterId);
+    if(param) {
+        mDataBuffer->setSerieHistory(parameterId,
+                                     qMax(param->historyDuration(), durationSec),
+                                     param->historySize());
+    }
+}
+
+qint64 QTBDataManager::historyMemory() const
+{
+    return mDataBuffer->allocatedBytes();
+}
+
+QTBDataArchive *QTBDataManager::archive() const
+{
+    return mArchive;
+}
+
+QTBDataReplay *QTBDataManager::replay() const
+{
+    return mReplay;
+}
+
+QTBParameterResolver *QTBDataManager::resolver() const
+{
+    return mResolver;
+}
+
+QTBDataExport *QTBDataManager::exportData(const QTBDataExportSettings &settings)
+{
+    QTBDataExport *dataExport = new QTBDataExport(this, settings);
+    dataExport->moveToThread(mExportThread);
+    connect(dataExport, SIGNAL(finished(bool, QString)), dataExport, SLOT(deleteLater()));
+    return dataExport;
+}
+
+void QTBDataManager::startReplay()
+{
+    if(mReplay && !mReplaying.loadAcquire()) {
+        mReplay->start();
+        mReplaying.storeRelease(1);
+    }
+}
+
+void QTBDataManager::stopReplay()
+{
+    if(mReplaying.loadAcquire()) {
+        mReplay->setPlaying(false);
+        mReplaying.storeRelease(0);
+        // the live samples merged from now on would follow the replayed ones
+        mResetPending.storeRelease(1);
+    }
+}
+
+bool QTBDataManager::replaying() const
+{
+    return mReplaying.loadAcquire();
+}
+
+void QTBDataManager::resetData()
+{
+    mDataBuffer->clearSeries();
+    mSnapshot.clear();
+    emit dataReset();
 }
 
 void QTBDataManager::updateData()
 {
-    QMutexLocker locker(&mMutex);
+    // the data buffer synchronizes each serie on its own, no lock is held
+    // while merging the sources nor while notifying the dashboard
+    if(mResetPending.fetchAndStoreAcquire(0))
+        resetData();
+
+    const bool replaying = mReplaying.loadAcquire();
+    if(!replaying && mReplay)
+        mReplay->releaseParameters();
+
     QMap<QString, DataSource *>::iterator i;
     for (i = mDataSources.begin(); i != mDataSources.end(); ++i) {
-        i.value()->updateDashboardData();
+        i.value()->updateDashboardData(!replaying);
     }
 
-    emit dataUpdated(QDateTime::currentDateTimeUtc());
-}
+    QTBTimestamp position = 0;
+    if(replaying)
+        position = mReplay->advance();
+    mSnapshot.publish(mDataBuffer.data());
 
-QHash<QString, QString> QTBDataManager::parameterSourceNames() const
-{
-    QMutexLocker locker(&mMutex);
-    return mParameterSourceNames;
+    if(replaying) {
+        emit dataUpdated(QDateTime::fromMSecsSinceEpoch(position / TIMESTAMP_NS_PER_MSEC, Qt::UTC));
+    } else {
+        emit dataUpdated(QDateTime::currentDateTimeUtc());
+    }
 }
 
 QMap<QString, DataSource *> QTBDataManager::dataSources() const
@@ -223,6 +393,8 @@ void QTBDataManager::loadDataSources()
                 DataSourceInterface *dataSource = qobject_cast<DataSourceInterface *>(plugin);
                 if(dataSource) {
                     dataSource->setDataManager(this);
+                    if(mArchive)
+                        dataSource->setArchiveStream(mArchive->stream(dir));
                     dataSource->setCurrentPath(pluginsDir.absoluteFilePath(dir));
                     mDataSources.insert(dir, dataSource);
                     if(dataSource->autoStart())
@@ -2,10 +2,17 @@
 #define DATAMANAGER_H
 
 #include <QObject>
+#include <QReadWriteLock>
+#include "data_archive.h"
+#include "data_replay.h"
+#include "data_export.h"
 #include "data_buffer.h"
-#include "data_parameter.h"
+#include "data_snapshot.h"
+#include "data_catalog.h"
+#include "data_resolver.h"
 
 #define TEMPO_MS_PARAM_UPDATE 500
+#define DATA_MERGE_PERIOD_MS 100
 
 class DataSource;
 class QTBDataManager : public QObject
@@ -16,6 +23,11 @@ public:
     ~QTBDataManager();
 
     bool registerParameter(const QSharedPointer<QTBParameter>& param);
+    // one lock, one pass on the series table and one notification for the whole list;
+    // returns the number of parameters registered, labels already known are skipped; the ones the
+    // buffer refuses (full or over its memory cap) are not registered and keep a parameter id of 0
+    int registerParameters(const QList<QSharedPointer<QTBParameter>>& params);
+    void unregisterParameters(const QVector<quint32>& parameterIds);
     void unregisterParameter(const QSharedPointer<QTBParameter>& param);
     void unregisterParameter(quint32 parameterId);
     void unregisterParameter(const QString& label);
@@ -25,22 +37,36 @@ public:
 
     QHash<quint32, QSharedPointer<QTBParameter> > parameters() const;
     QHash<QString, quint32> parameterLabels() const;
+    // source names at or below a '/'-separated path, all of them by default
+    QStringList parameterSources(const QString &prefix = QString()) const;
+    QStringList sourceLabels(const QString &sourceName) const;
 
-    void addSample(quint32 serieIndex, double timestamp, QTBDataValue value);
-    void addSampleUnsafe(quint32 serieIndex, double timestamp, QTBDataValue value);
-
+    // false when the sample came too late to be stored in order
+    bool addSample(quint32 serieIndex, QTBTimestamp timestamp, QTBDataValue value);
     QTBDataSample lastSample(quint32 serieIndex);
-    QTBDataSample lastSampleUnsafe(quint32 serieIndex);
+    // latest samples as of the last merge, see QTBDataSnapshot; GUI thread only
+    const QTBDataSnapshotTable *latestSamples();
+    QTBDataSerieView dataSerie(quint32 serieIndex);
+    QVector<QTBDataEnvelope> dataEnvelope(quint32 serieIndex, QTBTimestamp begin, QTBTimestamp end, int columns);
 
-    QTBDataSerie dataSerie(quint32 serieIndex);
-    QTBDataSerie dataSerieUnsafe(quint32 serieIndex);
+    void setHistory(quint32 parameterId, double durationSec);
+    qint64 historyMemory() const;
 
-    void lockData() { mMutex.lock(); }
-    void unlockData() { mMutex.unlock(); }
+    // null when no archive directory is set
+    QTBDataArchive *archive() const;
+    QTBDataReplay *replay() const;
+    // cached label bindings of the GUI, to use from the GUI thread only
+    QTBParameterResolver *resolver() const;
 
-    QMap<QString, DataSource*> dataSources() const;
+    // queued on the export thread, the caller connects then calls start()
+    QTBDataExport *exportData(const QTBDataExportSettings &settings);
 
-    QHash<QString, QString> parameterSourceNames() const;
+    // sources keep being archived, the buffer is fed from the archive
+    void startReplay();
+    void stopReplay();
+    bool replaying() const;
+
+    QMap<QString, DataSource*> dataSources() const;
 
 protected:
     void loadDataSources();
@@ -48,22 +74,35 @@ protected:
 signals:
     void parametersUpdated();
     void dataUpdated(QDateTime time);
+    // the buffer was emptied, dashboards reload their history
+    void dataReset();
     void newParameters();
+    // emitted once per registration or unregistration call, with the ids concerned
+    void parametersChanged(const QVector<quint32> &added, const QVector<quint32> &removed);
     void updateDashboard();
 
 public slots:
     void updateData();
 
+private:
+    friend class QTBDataReplay;
+    void resetData();
+
 protected:
     QSharedPointer<QTBDataBuffer> mDataBuffer;
-    QHash<quint32, QSharedPointer<QTBParameter>> mParameters;
-    QHash<QString, quint32> mParameterLabels;
-    QHash<QString, QString> mParameterSourceNames;
+    QTBDataSnapshot mSnapshot;
+    QTBDataArchive *mArchive;
+    QTBDataReplay *mReplay;
+    QTBParameterResolver *mResolver;
+    QAtomicInt mReplaying;
+    QAtomicInt mResetPending;
+    QTBParameterCatalog mCatalog;
     QTimer *mParametersTimer;
     QMap<QString, DataSource *> mDataSources;
     QThread *mThread;
     QTimer *mDataTimer;
-    mutable QMutex mMutex;
+    QThread *mExportThread;
+    mutable QReadWriteLock mParametersLock;
 };
 
 #endif // DATAMANAGER_H
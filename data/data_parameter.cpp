@@ -1,7 +1,10 @@
 #include "data_parameter.h"
+#include "data_common.h"
 
 QTBParameter::QTBParameter() :
-    mParameterId(0)
+    mParameterId(0),
+    mHistoryDuration(DEFAULT_DATA_HISTORY_SEC),
+    mHistorySize(DEFAULT_DATA_HISTORY_SAMPLES)
 {
 
 }
@@ -9,7 +12,9 @@ QTBParameter::QTBParameter() :
 QTBParameter::QTBParameter(const QTBParameter *parameter) :
     mParameterId(parameter->parameterId()),
     mLabel(parameter->label()),
-    mUnit(parameter->unit())
+    mUnit(parameter->unit()),
+    mHistoryDuration(parameter->historyDuration()),
+    mHistorySize(parameter->historySize())
 {
 
 }
@@ -54,6 +59,26 @@ void QTBParameter::setSourceName(const QString &sourceName)
     mSourceName = sourceName;
 }
 
+double QTBParameter::historyDuration() const
+{
+    return mHistoryDuration;
+}
+
+void QTBParameter::setHistoryDuration(double historyDuration)
+{
+    mHistoryDuration = historyDuration;
+}
+
+int QTBParameter::historySize() const
+{
+    return mHistorySize;
+}
+
+void QTBParameter::setHistorySize(int historySize)
+{
+    mHistorySize = historySize;
+}
+
 //void QTBParameter::setData(const QSharedPointer<QTBData> &data)
 //{
 //    mData = data;
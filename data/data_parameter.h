@@ -20,11 +20,19 @@ public:
     QString sourceName() const;
     void setSourceName(const QString &sourceName);
 
+    double historyDuration() const;
+    void setHistoryDuration(double historyDuration);
+
+    int historySize() const;
+    void setHistorySize(int historySize);
+
 protected:
     quint32         mParameterId;
     QString         mLabel;
     QString         mUnit;
     QString         mSourceName;
+    double          mHistoryDuration;
+    int             mHistorySize;
 
     void setParameterId(const quint32 &parameterId);
 
@@ -0,0 +1,212 @@
+#include "data_replay.h"
+#include "data_manager.h"
+
+QTBDataReplay::QTBDataReplay(QTBDataManager *dataManager, QTBDataArchive *archive, QObject *parent) :
+    QObject(parent),
+    mDataManager(dataManager),
+    mArchive(archive),
+    mFirst(0),
+    mLast(0),
+    mPosition(0),
+    mSpeed(1.0),
+    mPlaying(false),
+    mSeekPending(false),
+    mFed(0),
+    mStep(REPLAY_STEP_MIN_MS * TIMESTAMP_NS_PER_MSEC)
+{
+    mClock.start();
+}
+
+QTBTimestamp QTBDataReplay::first() const
+{
+    QMutexLocker locker(&mLock);
+    return mFirst;
+}
+
+QTBTimestamp QTBDataReplay::last() const
+{
+    QMutexLocker locker(&mLock);
+    return mLast;
+}
+
+QTBTimestamp QTBDataReplay::position() const
+{
+    QMutexLocker locker(&mLock);
+    return mPosition;
+}
+
+double QTBDataReplay::speed() const
+{
+    QMutexLocker locker(&mLock);
+    return mSpeed;
+}
+
+bool QTBDataReplay::playing() const
+{
+    QMutexLocker locker(&mLock);
+    return mPlaying;
+}
+
+void QTBDataReplay::setPlaying(bool playing)
+{
+    QMutexLocker locker(&mLock);
+    if(playing != mPlaying) {
+        mPlaying = playing;
+        mClock.restart();
+    }
+}
+
+void QTBDataReplay::seek(QTBTimestamp position)
+{
+    QMutexLocker locker(&mLock);
+    mPosition = qBound(mFirst, position, mLast);
+    mSeekPending = true;
+}
+
+void QTBDataReplay::setSpeed(double speed)
+{
+    QMutexLocker locker(&mLock);
+    mSpeed = qBound(REPLAY_SPEED_MIN, speed, REPLAY_SPEED_MAX);
+}
+
+void QTBDataReplay::start()
+{
+    QMutexLocker locker(&mLock);
+    if(!mArchive->timeRange(&mFirst, &mLast))
+        mFirst = mLast = 0;
+    mPosition = mFirst;
+    mPlaying = false;
+    mSeekPending = true;
+}
+
+QTBTimestamp QTBDataReplay::advance()
+{
+    bool reset = false;
+    QTBTimestamp target = 0;
+    {
+        QMutexLocker locker(&mLock);
+        const qint64 elapsed = mClock.restart() * TIMESTAMP_NS_PER_MSEC;
+        if(mSeekPending) {
+            mSeekPending = false;
+            reset = true;
+        } else if(mPlaying && mFed >= mPosition) {
+            // the clock only moves on once the samples it passed are merged
+            QTBTimestamp position = mPosition + QTBTimestamp(double(elapsed) * mSpeed);
+            if(position > mLast) {
+                // the archive may have grown since, live recording goes on
+                mArchive->timeRange(&mFirst, &mLast);
+                if(position >= mLast) {
+                    position = mLast;
+                    mPlaying = false;
+                }
+            }
+            mPosition = position;
+        }
+        target = mPosition;
+    }
+
+    if(reset) {
+        mDataManager->resetData();
+        updateSerieIndexes();
+        mFed = target - REPLAY_HISTORY_SEC * TIMESTAMP_NS_PER_SEC - 1;
+    }
+
+    // steps are widened while they are sparse and narrowed when one fills most of the tick
+    const QTBTimestamp minStep = REPLAY_STEP_MIN_MS * TIMESTAMP_NS_PER_MSEC;
+    const QTBTimestamp maxStep = REPLAY_STEP_MAX_MS * TIMESTAMP_NS_PER_MSEC;
+    quint64 fed = 0;
+    while(mFed < target && fed < REPLAY_TICK_MAX_SAMPLES) {
+        const QTBTimestamp end = qMin(target, mFed + mStep);
+        const quint64 samples = feed(mFed + 1, end);
+        fed += samples;
+        mFed = end;
+
+        if(samples < REPLAY_TICK_MAX_SAMPLES / 8)
+            mStep = qMin(maxStep, mStep * 2);
+        else if(samples > REPLAY_TICK_MAX_SAMPLES / 2)
+            mStep = qMax(minStep, mStep / 2);
+    }
+    return mFed;
+}
+
+void QTBDataReplay::releaseParameters()
+{
+    if(mParameterIds.isEmpty())
+        return;
+
+    mDataManager->unregisterParameters(mParameterIds);
+    mParameterIds.clear();
+    mSerieIndexes.clear();
+    mArchiveIds.clear();
+}
+
+void QTBDataReplay::updateSerieIndexes()
+{
+    QHash<QString, QHash<QString, quint32>> catalogs;
+    for(const QString &sourceName : mArchive->sources())
+        catalogs.insert(sourceName, mArchive->catalog(sourceName));
+
+    // archived labels are replayed in the parameters registered under the same label,
+    // the others get one for the time of the replay
+    QHash<QString, quint32> labels = mDataManager->parameterLabels();
+    QList<QSharedPointer<QTBParameter>> params;
+    QHash<QString, QHash<QString, quint32>>::const_iterator source;
+    for(source = catalogs.constBegin(); source != catalogs.constEnd(); ++source) {
+        for(const QString &label : source.value().keys()) {
+            if(!labels.contains(label)) {
+                QSharedPointer<QTBParameter> param(new QTBParameter());
+                param->setLabel(label);
+                param->setSourceName(source.key());
+                params.append(param);
+            }
+        }
+    }
+    if(!params.isEmpty()) {
+        mDataManager->registerParameters(params);
+        for(const QSharedPointer<QTBParameter> &param : params) {
+            if(param->parameterId() > 0) {
+                mParameterIds.append(param->parameterId());
+                labels.insert(param->label(), param->parameterId());
+            }
+        }
+    }
+
+    mSerieIndexes.clear();
+    mArchiveIds.clear();
+    for(source = catalogs.constBegin(); source != catalogs.constEnd(); ++source) {
+        QHash<quint32, quint32> &serieIndexes = mSerieIndexes[source.key()];
+        QBitArray &ids = mArchiveIds[source.key()];
+        const QHash<QString, quint32> &catalog = source.value();
+        QHash<QString, quint32>::const_iterator it;
+        for(it = catalog.constBegin(); it != catalog.constEnd(); ++it) {
+            quint32 serieIndex = labels.value(it.key(), 0);
+            if(serieIndex > 0) {
+                serieIndexes.insert(it.value(), serieIndex);
+                if(int(it.value()) >= ids.size())
+                    ids.resize(int(it.value()) + 1);
+                ids.setBit(int(it.value()));
+            }
+        }
+    }
+}
+
+quint64 QTBDataReplay::feed(QTBTimestamp begin, QTBTimestamp end)
+{
+    quint64 count = 0;
+    QTBDataManager *dataManager = mDataManager;
+    QHash<QString, QHash<quint32, quint32>>::const_iterator it;
+    for(it = mSerieIndexes.constBegin(); it != mSerieIndexes.constEnd(); ++it) {
+        const QHash<quint32, quint32> &serieIndexes = it.value();
+        if(serieIndexes.isEmpty())
+            continue;
+
+        mArchive->read(it.key(), mArchiveIds.value(it.key()), begin, end, [dataManager, &serieIndexes, &count](quint32 id, QTBTimestamp timestamp, QTBDataValue value) {
+            quint32 serieIndex = serieIndexes.value(id, 0);
+            if(serieIndex > 0) {
+                dataManager->addSample(serieIndex, timestamp, value);
+                count++;
+            }
+        });
+    }
+    return count;
+}
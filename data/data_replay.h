@@ -0,0 +1,84 @@
+#ifndef DATA_REPLAY_H
+#define DATA_REPLAY_H
+
+#include <QObject>
+#include <QMutex>
+#include <QElapsedTimer>
+#include "data_archive.h"
+
+#define REPLAY_SPEED_MIN 0.1
+#define REPLAY_SPEED_MAX 100.0
+#define REPLAY_HISTORY_SEC DEFAULT_DATA_HISTORY_SEC
+// samples merged per data tick, the archive is read by steps of recorded time until reached
+#define REPLAY_TICK_MAX_SAMPLES 262144
+#define REPLAY_STEP_MIN_MS 10
+#define REPLAY_STEP_MAX_MS 10000
+
+class QTBDataManager;
+
+/* Plays the archive back through the data manager. The position is a
+ * virtual clock, moved forward by the elapsed time times the speed on
+ * every data tick, and the samples archived in between are merged in the
+ * data buffer as if they came from the sources. A seek empties the buffer
+ * and reads back the history before the new position: only the archive
+ * chunks around it are read, whatever the size of the recording.
+ * A tick merges a bounded number of samples, the rest waits for the next
+ * ones and the clock waits with it: a dense recording or a high speed
+ * slows the playback down rather than the data thread.
+ * Archived labels are replayed in the parameters registered under the
+ * same label. The ones no running source registers get a parameter of
+ * their own, unregistered when the replay stops: a recording plays back
+ * without its source. A source registering one of these labels during
+ * the replay gets no parameter for it.
+ * Controls come from the GUI thread, advance() runs on the data thread. */
+class QTBDataReplay : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QTBDataReplay(QTBDataManager *dataManager, QTBDataArchive *archive, QObject *parent = nullptr);
+
+    QTBTimestamp first() const;
+    QTBTimestamp last() const;
+    QTBTimestamp position() const;
+    double speed() const;
+    bool playing() const;
+
+public slots:
+    void setPlaying(bool playing);
+    void seek(QTBTimestamp position);
+    void setSpeed(double speed);
+
+private:
+    friend class QTBDataManager;
+
+    void start();
+    QTBTimestamp advance();
+    // data thread, once the replay is over
+    void releaseParameters();
+    void updateSerieIndexes();
+    quint64 feed(QTBTimestamp begin, QTBTimestamp end);
+
+    QTBDataManager *mDataManager;
+    QTBDataArchive *mArchive;
+
+    mutable QMutex mLock;
+    QTBTimestamp mFirst;
+    QTBTimestamp mLast;
+    QTBTimestamp mPosition;
+    double mSpeed;
+    bool mPlaying;
+    bool mSeekPending;
+    QElapsedTimer mClock;
+
+    // data thread only, per source: archive catalog id to serie index
+    QHash<QString, QHash<quint32, quint32>> mSerieIndexes;
+    // and the catalog ids replayed, only their blocks are decoded
+    QHash<QString, QBitArray> mArchiveIds;
+    // the last timestamp merged, and the span of the next archive read
+    QTBTimestamp mFed;
+    QTBTimestamp mStep;
+    // registered for the archived labels without a live parameter
+    QVector<quint32> mParameterIds;
+};
+
+#endif // DATA_REPLAY_H
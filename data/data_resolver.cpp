@@ -0,0 +1,104 @@
+#include "data_resolver.h"
+#include "data_manager.h"
+
+QTBParameterResolver::QTBParameterResolver(QTBDataManager *dataManager, QObject *parent) :
+    QObject(parent),
+    mDataManager(dataManager)
+{
+    // parameters are registered from the source threads
+    qRegisterMetaType<QVector<quint32>>("QVector<quint32>");
+    connect(mDataManager, &QTBDataManager::parametersChanged,
+            this, &QTBParameterResolver::updateBindings, Qt::QueuedConnection);
+}
+
+QTBParameterBinding QTBParameterResolver::bind(const QString &label, QTBParameterSubscriber *subscriber)
+{
+    QHash<QString, Binding>::iterator it = mBindings.find(label);
+    if(it == mBindings.end()) {
+        it = mBindings.insert(label, Binding());
+        resolve(label, it.value());
+    }
+
+    if(subscriber && !it.value().subscribers.contains(subscriber)) {
+        it.value().subscribers.append(subscriber);
+        mSubscriptions[subscriber].append(label);
+    }
+    return it.value().binding;
+}
+
+void QTBParameterResolver::unsubscribe(QTBParameterSubscriber *subscriber)
+{
+    for(const QString &label : mSubscriptions.take(subscriber))
+        release(label, subscriber);
+}
+
+void QTBParameterResolver::unsubscribe(const QString &label, QTBParameterSubscriber *subscriber)
+{
+    QHash<QTBParameterSubscriber *, QVector<QString>>::iterator it = mSubscriptions.find(subscriber);
+    if(it == mSubscriptions.end() || !it.value().removeOne(label))
+        return;
+    if(it.value().isEmpty())
+        mSubscriptions.erase(it);
+    release(label, subscriber);
+}
+
+void QTBParameterResolver::release(const QString &label, QTBParameterSubscriber *subscriber)
+{
+    // bindings nobody subscribes to are dropped
+    QHash<QString, Binding>::iterator it = mBindings.find(label);
+    if(it == mBindings.end())
+        return;
+    it.value().subscribers.removeOne(subscriber);
+    if(it.value().subscribers.isEmpty()) {
+        mBoundLabels.remove(it.value().binding.parameterId);
+        mUnboundLabels.remove(label);
+        mBindings.erase(it);
+    }
+}
+
+void QTBParameterResolver::resolve(const QString &label, Binding &binding)
+{
+    QSharedPointer<QTBParameter> param = mDataManager->parameter(label);
+    if(param) {
+        binding.binding.parameterId = param->parameterId();
+        binding.binding.unit = param->unit();
+        mBoundLabels.insert(param->parameterId(), label);
+        mUnboundLabels.remove(label);
+    } else {
+        binding.binding = QTBParameterBinding();
+        mUnboundLabels.insert(label);
+    }
+}
+
+void QTBParameterResolver::updateBindings(const QVector<quint32> &added, const QVector<quint32> &removed)
+{
+    QSet<QTBParameterSubscriber *> rebound;
+
+    for(quint32 parameterId : removed) {
+        QHash<quint32, QString>::iterator it = mBoundLabels.find(parameterId);
+        if(it == mBoundLabels.end())
+            continue;
+        Binding &binding = mBindings[it.value()];
+        binding.binding = QTBParameterBinding();
+        mUnboundLabels.insert(it.value());
+        mBoundLabels.erase(it);
+        for(QTBParameterSubscriber *subscriber : binding.subscribers)
+            rebound.insert(subscriber);
+    }
+
+    // the labels waiting for a parameter are fewer than the ones registered
+    if(!added.isEmpty() && !mUnboundLabels.isEmpty()) {
+        const QSet<QString> unbound = mUnboundLabels;
+        for(const QString &label : unbound) {
+            Binding &binding = mBindings[label];
+            resolve(label, binding);
+            if(binding.binding.parameterId) {
+                for(QTBParameterSubscriber *subscriber : binding.subscribers)
+                    rebound.insert(subscriber);
+            }
+        }
+    }
+
+    for(QTBParameterSubscriber *subscriber : rebound)
+        subscriber->parametersRebound();
+}
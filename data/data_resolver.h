@@ -0,0 +1,60 @@
+#ifndef DATARESOLVER_H
+#define DATARESOLVER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+class QTBDataManager;
+
+struct QTBParameterBinding
+{
+    quint32 parameterId{0};     // 0 while the label is not registered
+    QString unit;
+};
+
+class QTBParameterSubscriber
+{
+public:
+    virtual ~QTBParameterSubscriber() {}
+    // one of the labels bound by the subscriber changed of parameter
+    virtual void parametersRebound() = 0;
+};
+
+/* Label to parameter id bindings for the GUI. A label is looked up in the
+ * data manager the first time it is bound, then answered from the cache.
+ * Registrations and unregistrations only touch the labels concerned: an
+ * unregistered id unbinds its label, new parameters are matched against
+ * the unbound labels, and only the subscribers of these labels are told. */
+class QTBParameterResolver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QTBParameterResolver(QTBDataManager *dataManager, QObject *parent = nullptr);
+
+    QTBParameterBinding bind(const QString &label, QTBParameterSubscriber *subscriber);
+    void unsubscribe(QTBParameterSubscriber *subscriber);
+    void unsubscribe(const QString &label, QTBParameterSubscriber *subscriber);
+
+private slots:
+    void updateBindings(const QVector<quint32> &added, const QVector<quint32> &removed);
+
+private:
+    struct Binding
+    {
+        QTBParameterBinding binding;
+        QVector<QTBParameterSubscriber *> subscribers;
+    };
+
+    void resolve(const QString &label, Binding &binding);
+    void release(const QString &label, QTBParameterSubscriber *subscriber);
+
+    QTBDataManager *mDataManager;
+    QHash<QString, Binding> mBindings;
+    QHash<quint32, QString> mBoundLabels;
+    QSet<QString> mUnboundLabels;
+    QHash<QTBParameterSubscriber *, QVector<QString>> mSubscriptions;
+};
+
+#endif // DATARESOLVER_H
@@ -3,6 +3,7 @@
 
 #include "3rdparty/qcustomplot.h"
 #include "data/data_value.h"
+#include "data/data_timestamp.h"
 
 class QTBDataSample
 {
@@ -11,24 +12,24 @@ public:
     QTBDataSample()
     {
         mCounter = 0.;
-        mDatationSec = 0;
+        mTimestamp = 0;
         mValue = QTBDataValue();
     }
 
-    QTBDataSample( double datationSec,
+    QTBDataSample( QTBTimestamp timestamp,
                    QTBDataValue val)
     {
         mCounter = 0.;
-        mDatationSec = datationSec;
+        mTimestamp = timestamp;
         mValue = val;
     }
 
     QTBDataSample(double counter,
-                  double datationSec,
+                  QTBTimestamp timestamp,
                   QTBDataValue val)
     {
         mCounter = counter;
-        mDatationSec = datationSec;
+        mTimestamp = timestamp;
         mValue = val;
     }
 
@@ -36,18 +37,19 @@ public:
     inline static QTBDataSample fromSortKey(double sortKey) { return QTBDataSample(sortKey,0, 0); }
     inline static bool sortKeyIsMainKey() { return true; }
 
-    inline double mainKey() const { return mDatationSec; }
+    inline double mainKey() const { return datationSec(); }
     inline double mainValue() { return double(mValue.uint32_value()); }
 
     inline QTBDataValue value() const { return mValue; }
-    inline double datationSec() const { return mDatationSec; }
-    inline double datationSecFromMidnight() const { return std::fmod(mDatationSec,86400.0); }
+    inline QTBTimestamp timestamp() const { return mTimestamp; }
+    // seconds since epoch, the unit of the plot keys
+    inline double datationSec() const { return timestampToSec(mTimestamp); }
 
     inline double counter() const { return mCounter; }
     void setCounter(double counter) { mCounter = counter; }
 private:
     double mCounter;
-    double mDatationSec;
+    QTBTimestamp mTimestamp;
     QTBDataValue mValue;
 };
 
@@ -0,0 +1,133 @@
+#ifndef DATA_SAMPLE_QUEUE_H
+#define DATA_SAMPLE_QUEUE_H
+
+#include <QAtomicInteger>
+#include <QVector>
+#include "data/data_value.h"
+#include "data/data_timestamp.h"
+
+// about 655k samples/s at the merge period of the data manager (DATA_MERGE_PERIOD_MS),
+// faster sources give their own capacity to DataSource
+#define SAMPLE_QUEUE_DEFAULT_CAPACITY 65536
+
+struct QTBDataRecord
+{
+    quint32         serieIndex;
+    QTBTimestamp    timestamp;
+    QTBDataValue    value;
+};
+Q_DECLARE_TYPEINFO(QTBDataRecord, Q_PRIMITIVE_TYPE);
+
+/* Bounded lock-free queue between one producer (the acquisition thread
+ * of a data source) and one consumer (the data manager thread).
+ * When the queue is full the new sample is rejected and counted. */
+class QTBDataSampleQueue
+{
+public:
+    explicit QTBDataSampleQueue(quint32 capacity = SAMPLE_QUEUE_DEFAULT_CAPACITY) :
+        mHead(0),
+        mTail(0),
+        mOverflowCount(0)
+    {
+        // round up to a power of two so that indexes wrap with a mask
+        quint32 size = 1;
+        while(size < capacity)
+            size <<= 1;
+
+        mRecords.resize(int(size));
+        mData = mRecords.data();
+        mMask = size - 1;
+    }
+
+    // producer side
+    bool push(quint32 serieIndex, QTBTimestamp timestamp, QTBDataValue value)
+    {
+        const quint32 tail = mTail.loadAcquire();
+        if(tail - mHead.loadAcquire() > mMask) {
+            mOverflowCount.fetchAndAddRelaxed(1);
+            return false;
+        }
+
+        QTBDataRecord &record = mData[tail & mMask];
+        record.serieIndex = serieIndex;
+        record.timestamp = timestamp;
+        record.value = value;
+
+        mTail.storeRelease(tail + 1);
+        return true;
+    }
+
+    // producer side, publishes the whole block at once, returns the number of samples queued
+    quint32 push(const QTBDataRecord *records, quint32 count)
+    {
+        const quint32 tail = mTail.loadAcquire();
+        const quint32 accepted = reserve(tail, count);
+
+        for(quint32 i = 0; i < accepted; ++i)
+            mData[(tail + i) & mMask] = records[i];
+
+        mTail.storeRelease(tail + accepted);
+        return accepted;
+    }
+
+    // producer side, one column of values sharing the same timestamp
+    quint32 push(QTBTimestamp timestamp, const quint32 *serieIndexes, const QTBDataValue *values, quint32 count)
+    {
+        const quint32 tail = mTail.loadAcquire();
+        const quint32 accepted = reserve(tail, count);
+
+        for(quint32 i = 0; i < accepted; ++i) {
+            QTBDataRecord &record = mData[(tail + i) & mMask];
+            record.serieIndex = serieIndexes[i];
+            record.timestamp = timestamp;
+            record.value = values[i];
+        }
+
+        mTail.storeRelease(tail + accepted);
+        return accepted;
+    }
+
+    // consumer side, calls func(const QTBDataRecord&) for every pending sample
+    template <class Func> quint32 drain(Func func)
+    {
+        const quint32 head = mHead.loadAcquire();
+        const quint32 tail = mTail.loadAcquire();
+
+        for(quint32 i = head; i != tail; ++i)
+            func(mData[i & mMask]);
+
+        mHead.storeRelease(tail);
+        return tail - head;
+    }
+
+    quint32 capacity() const { return mMask + 1; }
+    quint32 size() const { return mTail.loadAcquire() - mHead.loadAcquire(); }
+    quint64 overflowCount() const { return mOverflowCount.loadAcquire(); }
+
+private:
+    Q_DISABLE_COPY(QTBDataSampleQueue)
+
+    quint32 reserve(quint32 tail, quint32 count)
+    {
+        const quint32 available = mMask + 1 - (tail - mHead.loadAcquire());
+        if(count > available) {
+            mOverflowCount.fetchAndAddRelaxed(count - available);
+            return available;
+        }
+        return count;
+    }
+
+    QVector<QTBDataRecord> mRecords;
+    QTBDataRecord *mData;
+    quint32 mMask;
+
+    // head and tail are written by different threads, keep them on their own cache lines
+    char mPadding0[64];
+    QAtomicInteger<quint32> mHead;
+    char mPadding1[64];
+    QAtomicInteger<quint32> mTail;
+    QAtomicInteger<quint64> mOverflowCount;
+    char mPadding2[64];
+};
+
+#endif // DATA_SAMPLE_QUEUE_H
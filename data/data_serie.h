@@ -1,39 +1,552 @@
 #ifndef DATASERIE_H
 #define DATASERIE_H
 
+#include "data_common.h"
 #include "data_sample.h"
+#include "data_serie_tiers.h"
 #include <QDebug>
+#include <cstring>
+#include <iterator>
 
-#define SERIE_MAX_POINTS 1024
+// small: a serie is grown on demand, under the memory cap of its buffer
+#define SERIE_INITIAL_CAPACITY 16
+// newest samples among which a late one is put back in order
+#define SERIE_REORDER_WINDOW 1024
 
-class QTBDataSerie : public QCPDataContainer<QTBDataSample>
+/* Ring of samples: appending and evicting the oldest sample are O(1).
+ * The history kept is bounded by a duration and by a number of samples.
+ * With auto resize, the ring doubles while its oldest sample is still
+ * within the duration (the owner decides if memory allows it, see
+ * needsGrowth()), so it only reallocates until the rate is reached.
+ * Timestamps and values are stored in two separate arrays, values packed
+ * on the size of the serie type (1, 2 or 4 bytes). Counters are implicit:
+ * samples are numbered consecutively, the oldest one being at index 0.
+ * The const_iterator gives the same begin/end/findBegin access as
+ * QCPDataContainer for the elements iterating a serie, the samples it
+ * returns are built on the fly.
+ * Once the rate is known, coarser tiers (see QTBDataSerieTier) are kept up
+ * to date with every sample, envelope() reads them to downsample a range.
+ * Samples are kept in time order, which the lookups by timestamp rely on:
+ * a sample older than the last one stored is inserted in place when it
+ * falls among the SERIE_REORDER_WINDOW newest ones, the counters of the
+ * samples after it shift by one. Older than that, it is dropped and
+ * counted. */
+class QTBDataSerie
 {
 public:
-    QTBDataSerie():
-        QCPDataContainer<QTBDataSample>(),
+    class const_iterator
+    {
+    public:
+        // samples are not stored as such, operator-> hands out a copy
+        struct SamplePointer
+        {
+            QTBDataSample sample;
+            const QTBDataSample *operator->() const { return &sample; }
+        };
+
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef QTBDataSample value_type;
+        typedef int difference_type;
+        typedef SamplePointer pointer;
+        typedef QTBDataSample reference;
+
+        const_iterator() : mSerie(nullptr), mIndex(0) {}
+        const_iterator(const QTBDataSerie *serie, int index) : mSerie(serie), mIndex(index) {}
+
+        reference operator*() const { return mSerie->at(mIndex); }
+        pointer operator->() const { return SamplePointer{mSerie->at(mIndex)}; }
+        reference operator[](int n) const { return mSerie->at(mIndex + n); }
+
+        const_iterator &operator++() { ++mIndex; return *this; }
+        const_iterator operator++(int) { const_iterator it = *this; ++mIndex; return it; }
+        const_iterator &operator--() { --mIndex; return *this; }
+        const_iterator operator--(int) { const_iterator it = *this; --mIndex; return it; }
+        const_iterator &operator+=(int n) { mIndex += n; return *this; }
+        const_iterator &operator-=(int n) { mIndex -= n; return *this; }
+        const_iterator operator+(int n) const { return const_iterator(mSerie, mIndex + n); }
+        const_iterator operator-(int n) const { return const_iterator(mSerie, mIndex - n); }
+        int operator-(const const_iterator &other) const { return mIndex - other.mIndex; }
+
+        bool operator==(const const_iterator &other) const { return mIndex == other.mIndex; }
+        bool operator!=(const const_iterator &other) const { return mIndex != other.mIndex; }
+        bool operator<(const const_iterator &other) const { return mIndex < other.mIndex; }
+        bool operator<=(const const_iterator &other) const { return mIndex <= other.mIndex; }
+        bool operator>(const const_iterator &other) const { return mIndex > other.mIndex; }
+        bool operator>=(const const_iterator &other) const { return mIndex >= other.mIndex; }
+
+        int index() const { return mIndex; }
+
+    private:
+        const QTBDataSerie *mSerie;
+        int mIndex;
+    };
+
+    explicit QTBDataSerie(int capacity = SERIE_INITIAL_CAPACITY):
         mHistoryAutoResize(true),
-        mCounter(SERIE_MAX_POINTS)
+        mTiersActive(false),
+        mHistoryDuration(DEFAULT_DATA_HISTORY_SEC * TIMESTAMP_NS_PER_SEC),
+        mHistorySize(DEFAULT_DATA_HISTORY_SAMPLES),
+        mValueType(QTBDataValue::TYPE_UINT32),
+        mValueSize(QTBDataValue::valueSize(QTBDataValue::TYPE_UINT32)),
+        mCapacity(qMax(capacity, 1)),
+        mHead(0),
+        mSize(0),
+        mCounter(1),
+        mLateSamples(0)
     {
-        preallocateGrow(SERIE_MAX_POINTS);
+        mTimestamps.resize(mCapacity);
+        mValues.resize(mCapacity * mValueSize);
     }
 
-    void addSample(double timestamp, QTBDataValue value)
+    // the value is stored with the serie type, see setValueType(); false when
+    // the sample came too late to be put in order and was dropped
+    bool addSample(QTBTimestamp timestamp, QTBDataValue value)
     {
-        QTBDataSample sample(mCounter, timestamp, value);
+        int index = mSize;
+        if(mSize > 0 && timestamp < timestampAt(mSize - 1)) {
+            // after the stored samples of the same time, within the window only
+            const int first = qMax(0, mSize - SERIE_REORDER_WINDOW);
+            if(first > 0 && timestamp < timestampAt(first)) {
+                mLateSamples++;
+                return false;
+            }
+            index = findAfter(timestamp, first);
+        }
+
+        // a full ring drops its oldest sample
+        if(mSize == mCapacity) {
+            if(index == 0) {
+                mLateSamples++;
+                return false;
+            }
+            removeFirst();
+            index--;
+        }
+        if(index < mSize)
+            openGap(index);
+
+        const int pos = position(index);
+        mTimestamps[pos] = timestamp;
+        memcpy(mValues.data() + pos * mValueSize, &value.mValue, size_t(mValueSize));
         mCounter++;
+        mSize++;
+
+        // time based retention, from the newest sample
+        const QTBTimestamp limit = timestampAt(mSize - 1) - mHistoryDuration;
+        while(mSize > 1 && timestampAt(0) < limit)
+            removeFirst();
+
+        if(mTiersActive) {
+            const double tierValue = value.toDouble();
+            for(int i = 0; i < SERIE_TIER_COUNT; i++) {
+                if(mTiers[i].capacity() > 0) {
+                    mTiers[i].add(timestamp, tierValue);
+                    mTiers[i].removeBefore(limit);
+                }
+            }
+        }
+        return true;
+    }
+
+    // true when the ring is full of samples that are all still to be kept
+    bool needsGrowth(QTBTimestamp timestamp) const
+    {
+        return mHistoryAutoResize &&
+                mSize == mCapacity &&
+                mSize < mHistorySize &&
+                timestampAt(0) >= timestamp - mHistoryDuration;
+    }
+
+    int grownCapacity() const { return qMin(2 * mCapacity, mHistorySize); }
+
+    // reallocates the ring, keeping the newest samples, and plans the tiers for the current rate
+    void resize(int capacity)
+    {
+        capacity = qMax(capacity, 1);
+        if(capacity == mCapacity)
+            return;
 
-        add(sample);
-        removeBefore(mCounter - SERIE_MAX_POINTS);
+        const double period = samplePeriod();
+        const int kept = qMin(mSize, capacity);
+        QVector<QTBTimestamp> timestamps(capacity);
+        QVector<uchar> values(capacity * mValueSize);
+        int copied = 0;
+        while(copied < kept) {
+            const int pos = position(mSize - kept + copied);
+            const int block = qMin(kept - copied, mCapacity - pos);
+            memcpy(timestamps.data() + copied, mTimestamps.constData() + pos, size_t(block) * sizeof(QTBTimestamp));
+            memcpy(values.data() + copied * mValueSize, mValues.constData() + pos * mValueSize, size_t(block * mValueSize));
+            copied += block;
+        }
+
+        mTimestamps = timestamps;
+        mValues = values;
+        mCapacity = capacity;
+        mHead = 0;
+        mSize = kept;
+
+        planTiers(period);
+    }
+
+    int sampleBytes() const { return int(sizeof(QTBTimestamp)) + mValueSize; }
+
+    int bytes() const
+    {
+        int bytes = mCapacity * sampleBytes();
+        for(int i = 0; i < SERIE_TIER_COUNT; i++)
+            bytes += mTiers[i].bytes();
+        return bytes;
     }
 
+    // what bytes() will be after resize(capacity)
+    int plannedBytes(int capacity) const
+    {
+        const double period = samplePeriod();
+        int bytes = qMax(capacity, 1) * sampleBytes();
+        QTBTimestamp width = SERIE_TIER_BASE_NS;
+        for(int i = 0; i < SERIE_TIER_COUNT; i++) {
+            bytes += tierBuckets(width, period) * int(sizeof(QTBDataSerieTier::Bucket));
+            width *= SERIE_TIER_FACTOR;
+        }
+        return bytes;
+    }
+
+    QTBDataValue::ValueType valueType() const { return mValueType; }
+
+    // stored values can't be reinterpreted, changing the type clears the serie
+    void setValueType(QTBDataValue::ValueType valueType)
+    {
+        if(valueType == mValueType)
+            return;
+
+        mValueType = valueType;
+        mValueSize = QTBDataValue::valueSize(valueType);
+        mValues = QVector<uchar>(mCapacity * mValueSize);
+        clear();
+    }
+
+    void setHistory(double durationSec, int maxSamples)
+    {
+        mHistoryDuration = timestampFromSec(durationSec);
+        mHistorySize = qMax(maxSamples, 1);
+
+        if(!mHistoryAutoResize) {
+            resize(mHistorySize);
+            planTiers(samplePeriod());
+            return;
+        }
+
+        // give back the memory the new retention does not need anymore
+        if(mSize > 0) {
+            const QTBTimestamp limit = timestampAt(mSize - 1) - mHistoryDuration;
+            while(mSize > 1 && timestampAt(0) < limit)
+                removeFirst();
+        }
+
+        int capacity = SERIE_INITIAL_CAPACITY;
+        while(capacity < mSize)
+            capacity *= 2;
+        capacity = qMin(capacity, mHistorySize);
+        if(capacity < mCapacity)
+            resize(capacity);
+        planTiers(samplePeriod());
+    }
+
+    double historyDuration() const { return timestampToSec(mHistoryDuration); }
+    int historySize() const { return mHistorySize; }
+
+    void clear()
+    {
+        mHead = 0;
+        mSize = 0;
+        for(int i = 0; i < SERIE_TIER_COUNT; i++)
+            mTiers[i].clear();
+    }
+
+    int size() const { return mSize; }
+    bool isEmpty() const { return mSize == 0; }
+    int capacity() const { return mCapacity; }
+    // samples dropped for coming too late, see SERIE_REORDER_WINDOW
+    quint64 lateSamples() const { return mLateSamples; }
+
+    // index 0 is the oldest sample
+    QTBDataSample at(int index) const
+    {
+        return QTBDataSample(double(mCounter - quint32(mSize - index)), timestampAt(index), valueAt(index));
+    }
+
+    QTBDataSample last() const { return at(mSize - 1); }
+
+    QTBTimestamp timestampAt(int index) const { return mTimestamps.constData()[position(index)]; }
+
+    QTBDataValue valueAt(int index) const
+    {
+        QTBDataValue value;
+        value.mType = mValueType;
+        memcpy(&value.mValue, mValues.constData() + position(index) * mValueSize, size_t(mValueSize));
+        return value;
+    }
+
+    /* Copies count samples from index to plain arrays, values converted to
+     * double. One typed loop per contiguous block, for the scans that should
+     * not go through the iterator. */
+    void copy(int index, int count, QTBTimestamp *timestamps, double *values) const
+    {
+        while(count > 0) {
+            const int pos = position(index);
+            const int block = qMin(count, mCapacity - pos);
+            const uchar *data = mValues.constData() + pos * mValueSize;
+
+            memcpy(timestamps, mTimestamps.constData() + pos, size_t(block) * sizeof(QTBTimestamp));
+            switch(mValueType) {
+            case QTBDataValue::TYPE_INT8:
+                convert(reinterpret_cast<const qint8*>(data), block, values);
+                break;
+            case QTBDataValue::TYPE_UINT8:
+                convert(reinterpret_cast<const quint8*>(data), block, values);
+                break;
+            case QTBDataValue::TYPE_INT16:
+                convert(reinterpret_cast<const qint16*>(data), block, values);
+                break;
+            case QTBDataValue::TYPE_UINT16:
+                convert(reinterpret_cast<const quint16*>(data), block, values);
+                break;
+            case QTBDataValue::TYPE_INT32:
+                convert(reinterpret_cast<const qint32*>(data), block, values);
+                break;
+            case QTBDataValue::TYPE_UINT32:
+                convert(reinterpret_cast<const quint32*>(data), block, values);
+                break;
+            case QTBDataValue::TYPE_FLOAT:
+                convert(reinterpret_cast<const float*>(data), block, values);
+                break;
+            }
+
+            index += block;
+            count -= block;
+            timestamps += block;
+            values += block;
+        }
+    }
+
+    const_iterator constBegin() const { return const_iterator(this, 0); }
+    const_iterator constEnd() const { return const_iterator(this, mSize); }
+
+    // first sample at or after the timestamp
+    const_iterator findTimestamp(QTBTimestamp timestamp) const
+    {
+        int low = 0;
+        int high = mSize;
+        while(low < high) {
+            const int middle = (low + high) / 2;
+            if(timestampAt(middle) < timestamp)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return const_iterator(this, low);
+    }
+
+    /* Min, max and mean of the samples in [begin, end] over columns of equal
+     * duration, empty columns are left out. The coarsest tier that still has
+     * at least one bucket per column is read, so the cost follows the number
+     * of columns and not the history length, the range bounds are rounded
+     * to its buckets. Samples are read one by one
+     * only when no tier is fine enough, or covers the range. */
+    QVector<QTBDataEnvelope> envelope(QTBTimestamp begin, QTBTimestamp end, int columns) const
+    {
+        QVector<QTBDataEnvelope> envelopes;
+        if(columns <= 0 || end < begin || mSize == 0)
+            return envelopes;
+
+        const QTBTimestamp columnWidth = (end - begin) / columns + 1;
+        QVector<QTBDataEnvelope> buckets(columns);
+        for(int i = 0; i < columns; i++) {
+            buckets[i].timestamp = begin + i * columnWidth;
+            buckets[i].count = 0;
+        }
+
+        const QTBDataSerieTier *tier = nullptr;
+        for(int i = SERIE_TIER_COUNT - 1; i >= 0 && !tier; i--) {
+            const QTBDataSerieTier &candidate = mTiers[i];
+            if(!candidate.isEmpty() && candidate.width() <= columnWidth) {
+                const QTBTimestamp first = candidate.bucketBegin(candidate.at(0));
+                if(first <= begin || first <= timestampAt(0))
+                    tier = &candidate;
+            }
+        }
+
+        if(tier) {
+            for(int i = tier->findBegin(begin); i < tier->size(); i++) {
+                const QTBDataSerieTier::Bucket &bucket = tier->at(i);
+                const QTBTimestamp timestamp = qMax(tier->bucketBegin(bucket), begin);
+                if(timestamp > end)
+                    break;
+                merge(buckets[int((timestamp - begin) / columnWidth)], bucket.min, bucket.max, bucket.sum, bucket.count);
+            }
+        } else {
+            for(int i = findTimestamp(begin).index(); i < mSize; i++) {
+                const QTBTimestamp timestamp = timestampAt(i);
+                if(timestamp > end)
+                    break;
+                const double value = valueAt(i).toDouble();
+                merge(buckets[int((timestamp - begin) / columnWidth)], value, value, value, 1);
+            }
+        }
+
+        for(int i = 0; i < columns; i++) {
+            if(buckets.at(i).count > 0) {
+                QTBDataEnvelope envelope = buckets.at(i);
+                envelope.mean /= envelope.count;
+                envelopes.append(envelope);
+            }
+        }
+        return envelopes;
+    }
+
+    // counters are consecutive, the lookup is a subtraction
+    const_iterator findBegin(double counter, bool expandedRange=false) const
+    {
+        Q_UNUSED(expandedRange)
+        const double first = double(mCounter - quint32(mSize));
+        if(counter <= first)
+            return constBegin();
+        if(counter >= double(mCounter))
+            return constEnd();
+        return const_iterator(this, int(std::ceil(counter - first)));
+    }
+
+    bool historyAutoResize() const { return mHistoryAutoResize; }
+
     void setHistoryAutoResize(bool historyAutoResize)
     {
         mHistoryAutoResize = historyAutoResize;
+        if(!mHistoryAutoResize)
+            resize(mHistorySize);
     }
 
 private:
+    // mean time between the stored samples, in ns
+    double samplePeriod() const
+    {
+        if(mSize < 2)
+            return 0;
+        return double(timestampAt(mSize - 1) - timestampAt(0)) / (mSize - 1);
+    }
+
+    // a tier is worth it when its buckets gather several samples, it covers the history duration
+    int tierBuckets(QTBTimestamp width, double period) const
+    {
+        if(period <= 0 || double(width) < SERIE_TIER_MIN_SAMPLES * period)
+            return 0;
+        return int(qMin(qint64(SERIE_TIER_MAX_BUCKETS), mHistoryDuration / width + 2));
+    }
+
+    void planTiers(double period)
+    {
+        mTiersActive = false;
+        QTBTimestamp width = SERIE_TIER_BASE_NS;
+        for(int i = 0; i < SERIE_TIER_COUNT; i++) {
+            QTBDataSerieTier &tier = mTiers[i];
+            const int buckets = tierBuckets(width, period);
+            if(buckets != tier.capacity() || width != tier.width()) {
+                const bool created = tier.capacity() == 0;
+                tier.reset(width, buckets);
+
+                // a new tier starts with the samples already stored
+                if(created && buckets > 0) {
+                    for(int j = 0; j < mSize; j++)
+                        tier.add(timestampAt(j), valueAt(j).toDouble());
+                }
+            }
+            if(buckets > 0)
+                mTiersActive = true;
+            width *= SERIE_TIER_FACTOR;
+        }
+    }
+
+    static void merge(QTBDataEnvelope &envelope, double min, double max, double sum, quint32 count)
+    {
+        if(envelope.count == 0) {
+            envelope.min = min;
+            envelope.max = max;
+            envelope.mean = sum;
+        } else {
+            envelope.min = qMin(envelope.min, min);
+            envelope.max = qMax(envelope.max, max);
+            envelope.mean += sum;
+        }
+        envelope.count += count;
+    }
+
+    int position(int index) const
+    {
+        int pos = mHead + index;
+        if(pos >= mCapacity)
+            pos -= mCapacity;
+        return pos;
+    }
+
+    // index of the first sample after the timestamp, searched from first
+    int findAfter(QTBTimestamp timestamp, int first) const
+    {
+        int low = first;
+        int high = mSize;
+        while(low < high) {
+            const int middle = (low + high) / 2;
+            if(timestampAt(middle) <= timestamp)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low;
+    }
+
+    // moves the samples from index on one place up, the ring is not full
+    void openGap(int index)
+    {
+        int end = mSize;
+        while(end > index) {
+            const int to = position(end);
+            const int from = position(end - 1);
+            // the block ending at from that moves without wrapping
+            const int block = to == 0 ? 1 : qMin(end - index, to);
+            const int source = from - block + 1;
+            const int target = to == 0 ? 0 : source + 1;
+            memmove(mTimestamps.data() + target, mTimestamps.constData() + source, size_t(block) * sizeof(QTBTimestamp));
+            memmove(mValues.data() + target * mValueSize, mValues.constData() + source * mValueSize, size_t(block * mValueSize));
+            end -= block;
+        }
+    }
+
+    void removeFirst()
+    {
+        mHead++;
+        if(mHead == mCapacity)
+            mHead = 0;
+        mSize--;
+    }
+
+    template <class T> static void convert(const T *data, int count, double *values)
+    {
+        for(int i = 0; i < count; i++)
+            values[i] = double(data[i]);
+    }
+
+    QVector<QTBTimestamp> mTimestamps;
+    QVector<uchar> mValues;
+    QTBDataSerieTier mTiers[SERIE_TIER_COUNT];
     bool mHistoryAutoResize;
+    bool mTiersActive;
+    QTBTimestamp mHistoryDuration;
+    int mHistorySize;
+    QTBDataValue::ValueType mValueType;
+    int mValueSize;
+    int mCapacity;
+    int mHead;
+    int mSize;
     quint32 mCounter;
+    quint64 mLateSamples;
 };
 
 Q_DECLARE_TYPEINFO(QTBDataSerie, Q_MOVABLE_TYPE);
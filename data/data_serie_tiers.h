@@ -0,0 +1,206 @@
+#ifndef DATA_SERIE_TIERS_H
+#define DATA_SERIE_TIERS_H
+
+#include <QVector>
+#include <cstring>
+#include "data_timestamp.h"
+
+#define SERIE_TIER_COUNT 6
+#define SERIE_TIER_BASE_NS (10 * TIMESTAMP_NS_PER_MSEC)
+#define SERIE_TIER_FACTOR 8
+#define SERIE_TIER_MAX_BUCKETS 8192
+// a tier is only kept when its buckets gather at least this number of samples
+#define SERIE_TIER_MIN_SAMPLES 4
+
+// one column of a downsampled range
+struct QTBDataEnvelope
+{
+    QTBTimestamp    timestamp;  // begin of the column
+    double          min;
+    double          max;
+    double          mean;
+    quint32         count;
+};
+Q_DECLARE_TYPEINFO(QTBDataEnvelope, Q_PRIMITIVE_TYPE);
+
+/* One resolution level of a serie: a ring of fixed width time buckets
+ * holding the min, max, sum and count of the samples that fell in them.
+ * Buckets are created as samples come in, empty time slots have no bucket.
+ * The ring stays sorted on time: a late sample is merged in its bucket,
+ * or gets a bucket inserted in place. It is only dropped and counted when
+ * its bucket would be older than the whole ring. */
+class QTBDataSerieTier
+{
+public:
+    struct Bucket
+    {
+        qint64  index;      // timestamp / width
+        double  min;
+        double  max;
+        double  sum;
+        quint32 count;
+    };
+
+    QTBDataSerieTier() :
+        mWidth(SERIE_TIER_BASE_NS),
+        mHead(0),
+        mSize(0),
+        mDropped(0) {}
+
+    // reallocates the ring, keeping the newest buckets
+    void reset(QTBTimestamp width, int capacity)
+    {
+        if(width != mWidth) {
+            mWidth = width;
+            mSize = 0;
+        }
+
+        const int kept = qMin(mSize, capacity);
+        QVector<Bucket> buckets(capacity);
+        for(int i = 0; i < kept; i++)
+            buckets[i] = at(mSize - kept + i);
+
+        mBuckets = buckets;
+        mHead = 0;
+        mSize = kept;
+    }
+
+    void clear()
+    {
+        mHead = 0;
+        mSize = 0;
+    }
+
+    void add(QTBTimestamp timestamp, double value)
+    {
+        const qint64 index = bucketIndex(timestamp);
+        int target = mSize;
+        if(mSize > 0) {
+            int last = mSize - 1;
+            if(index < at(last).index)
+                last = find(index);
+
+            Bucket &bucket = mBuckets[position(last)];
+            if(bucket.index == index) {
+                bucket.min = qMin(bucket.min, value);
+                bucket.max = qMax(bucket.max, value);
+                bucket.sum += value;
+                bucket.count++;
+                return;
+            }
+            if(index < bucket.index)
+                target = last;
+        }
+
+        // a full ring drops its oldest bucket
+        if(mSize == mBuckets.size()) {
+            if(target == 0) {
+                mDropped++;
+                return;
+            }
+            removeFirst();
+            target--;
+        }
+        if(target < mSize)
+            openGap(target);
+
+        Bucket &bucket = mBuckets[position(target)];
+        bucket.index = index;
+        bucket.min = value;
+        bucket.max = value;
+        bucket.sum = value;
+        bucket.count = 1;
+        mSize++;
+    }
+
+    // drops the buckets that end before the timestamp
+    void removeBefore(QTBTimestamp timestamp)
+    {
+        const qint64 index = bucketIndex(timestamp);
+        while(mSize > 0 && at(0).index < index)
+            removeFirst();
+    }
+
+    // index of the first bucket at or after the timestamp bucket
+    int findBegin(QTBTimestamp timestamp) const
+    {
+        return find(bucketIndex(timestamp));
+    }
+
+    QTBTimestamp width() const { return mWidth; }
+    QTBTimestamp bucketBegin(const Bucket &bucket) const { return bucket.index * mWidth; }
+
+    int size() const { return mSize; }
+    bool isEmpty() const { return mSize == 0; }
+    int capacity() const { return mBuckets.size(); }
+    int bytes() const { return mBuckets.size() * int(sizeof(Bucket)); }
+    // late samples older than the whole ring
+    quint64 dropped() const { return mDropped; }
+
+    const Bucket &at(int index) const { return mBuckets.constData()[position(index)]; }
+
+private:
+    int find(qint64 index) const
+    {
+        int low = 0;
+        int high = mSize;
+        while(low < high) {
+            const int middle = (low + high) / 2;
+            if(at(middle).index < index)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        return low;
+    }
+
+    qint64 bucketIndex(QTBTimestamp timestamp) const
+    {
+        // rounds towards minus infinity, timestamps before 1970 are valid
+        qint64 index = timestamp / mWidth;
+        if(timestamp % mWidth < 0)
+            index--;
+        return index;
+    }
+
+    int position(int index) const
+    {
+        int pos = mHead + index;
+        if(pos >= mBuckets.size())
+            pos -= mBuckets.size();
+        return pos;
+    }
+
+    void removeFirst()
+    {
+        mHead++;
+        if(mHead == mBuckets.size())
+            mHead = 0;
+        mSize--;
+    }
+
+    // moves the buckets from index on one place up, the ring is not full
+    void openGap(int index)
+    {
+        int end = mSize;
+        while(end > index) {
+            const int to = position(end);
+            const int from = position(end - 1);
+            const int block = to == 0 ? 1 : qMin(end - index, to);
+            const int source = from - block + 1;
+            const int target = to == 0 ? 0 : source + 1;
+            memmove(mBuckets.data() + target, mBuckets.constData() + source, size_t(block) * sizeof(Bucket));
+            end -= block;
+        }
+    }
+
+    QVector<Bucket> mBuckets;
+    QTBTimestamp mWidth;
+    int mHead;
+    int mSize;
+    quint64 mDropped;
+};
+
+Q_DECLARE_TYPEINFO(QTBDataSerieTier, Q_MOVABLE_TYPE);
+
+#endif // DATA_SERIE_TIERS_H
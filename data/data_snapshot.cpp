@@ -0,0 +1,72 @@
+#include "data_snapshot.h"
+
+QTBDataSnapshot::QTBDataSnapshot() :
+    mState(1),
+    mBack(2),
+    mFront(0),
+    mTick(0)
+{
+
+}
+
+void QTBDataSnapshot::clear()
+{
+    for(int i = 0; i < DATA_SNAPSHOT_TABLES; i++)
+        mTables[i].mCleared = true;
+}
+
+void QTBDataSnapshot::publish(QTBDataBuffer *buffer)
+{
+    // the changes of the merge are pending for every table
+    for(int i = 0; i < DATA_SNAPSHOT_TABLES; i++) {
+        QTBDataSnapshotTable &table = mTables[i];
+        if(table.mPendingMarks.size() < mChangedMarks.size())
+            table.mPendingMarks.resize(mChangedMarks.size());
+        for(quint32 serieIndex : mChanged) {
+            const int slot = int(QTBDataBuffer::serieSlot(serieIndex));
+            if(!table.mPendingMarks.at(slot)) {
+                table.mPendingMarks[slot] = 1;
+                table.mPending.append(serieIndex);
+            }
+        }
+    }
+    for(quint32 serieIndex : mChanged)
+        mChangedMarks[int(QTBDataBuffer::serieSlot(serieIndex))] = 0;
+    mChanged.clear();
+
+    write(mTables[mBack], buffer, ++mTick);
+    mBack = mState.fetchAndStoreOrdered(mBack | DATA_SNAPSHOT_FRESH) & ~DATA_SNAPSHOT_FRESH;
+}
+
+void QTBDataSnapshot::write(QTBDataSnapshotTable &table, QTBDataBuffer *buffer, quint64 tick)
+{
+    table.mPreviousTick = table.mTick;
+    table.mTick = tick;
+
+    // every serie marked so far has its slot in the table
+    if(table.mEntries.size() < table.mPendingMarks.size())
+        table.mEntries.resize(table.mPendingMarks.size());
+
+    if(table.mCleared) {
+        table.mEntries.fill(QTBDataSnapshotTable::Entry());
+        table.mCleared = false;
+        table.mClearedTick = tick;
+    }
+
+    for(quint32 serieIndex : table.mPending) {
+        const int slot = int(QTBDataBuffer::serieSlot(serieIndex));
+        table.mPendingMarks[slot] = 0;
+        QTBDataSnapshotTable::Entry &entry = table.mEntries[slot];
+        entry.serieIndex = serieIndex;
+        entry.sample = buffer->lastSample(serieIndex);
+    }
+    table.mWritten.swap(table.mPending);
+    table.mPending.clear();
+}
+
+const QTBDataSnapshotTable *QTBDataSnapshot::acquire()
+{
+    if(mState.loadAcquire() & DATA_SNAPSHOT_FRESH)
+        mFront = mState.fetchAndStoreOrdered(mFront) & ~DATA_SNAPSHOT_FRESH;
+    return &mTables[mFront];
+}
@@ -0,0 +1,106 @@
+#ifndef DATASNAPSHOT_H
+#define DATASNAPSHOT_H
+
+#include <QVector>
+#include <QAtomicInt>
+#include "data_buffer.h"
+
+#define DATA_SNAPSHOT_TABLES 3
+#define DATA_SNAPSHOT_FRESH 0x4
+
+/* Latest sample of every serie, as of the end of a merge, indexed by the
+ * slot of the serie. */
+class QTBDataSnapshotTable
+{
+public:
+    // an empty sample for an unknown or removed serie
+    QTBDataSample sample(quint32 serieIndex) const
+    {
+        const int slot = int(QTBDataBuffer::serieSlot(serieIndex));
+        if(slot < mEntries.size() && mEntries.at(slot).serieIndex == serieIndex)
+            return mEntries.at(slot).sample;
+        return QTBDataSample();
+    }
+
+    // number of the merge the table was published at
+    quint64 tick() const { return mTick; }
+    // the series whose latest sample changed after the given merge; false
+    // when the table can't tell, as the merges between were not all seen or
+    // the buffer was emptied, and every serie is to be taken as changed
+    bool changedSince(quint64 tick, QVector<quint32> &serieIndexes) const
+    {
+        if(tick >= mTick)
+            return true;
+        if(tick < mPreviousTick || tick < mClearedTick)
+            return false;
+        serieIndexes += mWritten;
+        return true;
+    }
+
+private:
+    friend class QTBDataSnapshot;
+
+    struct Entry
+    {
+        quint32 serieIndex{0};
+        QTBDataSample sample;
+    };
+
+    QVector<Entry> mEntries;
+    quint64 mTick{0};
+    quint64 mPreviousTick{0};
+    quint64 mClearedTick{0};
+    // series written at mTick, all the ones changed since mPreviousTick
+    QVector<quint32> mWritten;
+    // series changed since the table was last written, and their marks by slot
+    QVector<quint32> mPending;
+    QVector<quint8> mPendingMarks;
+    bool mCleared{false};
+};
+
+/* Hands the latest samples from the data thread to the GUI without a lock.
+ * The data thread marks the series it appends to, and at the end of each
+ * merge writes their last sample in a spare table which it then swaps in
+ * with one atomic exchange. The GUI takes the newest table with another
+ * exchange, then reads a whole frame from it. A third table lets the data
+ * thread publish again while the GUI still reads its own, a table is only
+ * written with the series changed since its last turn, which it keeps as
+ * the set of changes for the GUI. */
+class QTBDataSnapshot
+{
+public:
+    QTBDataSnapshot();
+
+    // data thread
+    void markChanged(quint32 serieIndex)
+    {
+        const int slot = int(QTBDataBuffer::serieSlot(serieIndex));
+        if(slot >= mChangedMarks.size())
+            mChangedMarks.resize(slot + 1);
+        if(!mChangedMarks.at(slot)) {
+            mChangedMarks[slot] = 1;
+            mChanged.append(serieIndex);
+        }
+    }
+    // the buffer was emptied, every table starts over
+    void clear();
+    void publish(QTBDataBuffer *buffer);
+
+    // GUI thread, the table stays valid until the next call
+    const QTBDataSnapshotTable *acquire();
+
+private:
+    void write(QTBDataSnapshotTable &table, QTBDataBuffer *buffer, quint64 tick);
+
+    QTBDataSnapshotTable mTables[DATA_SNAPSHOT_TABLES];
+    // index of the table last published, with DATA_SNAPSHOT_FRESH until taken
+    QAtomicInt mState;
+    int mBack;
+    int mFront;
+    quint64 mTick;
+
+    QVector<quint32> mChanged;
+    QVector<quint8> mChangedMarks;
+};
+
+#endif // DATASNAPSHOT_H
@@ -2,6 +2,7 @@
 #define DATA_SOURCE_H
 
 #include "data_manager.h"
+#include "data_sample_queue.h"
 
 class DataSource : public QObject
 {
@@ -15,9 +16,14 @@ public:
     };
     Q_ENUM(DataSourceStatus)
 
-    DataSource() : QObject(),
+    // the queue holds what the source produces over a merge period of the data manager
+    // (DATA_MERGE_PERIOD_MS), samples beyond are dropped and counted
+    explicit DataSource(quint32 queueCapacity = SAMPLE_QUEUE_DEFAULT_CAPACITY) : QObject(),
         mDataManager(nullptr),
+        mArchiveStream(nullptr),
         mStatus(dssIdle),
+        mQueue(queueCapacity),
+        mLateSamples(0),
         mAutoStart(false) {}
 
     virtual ~DataSource() {}
@@ -35,12 +41,67 @@ public:
         mAutoStart = autoStart;
     }
 
-    void updateSample(quint32 serieIndex, double timestamp, QTBDataValue value)
+    // to be called from a single acquisition thread, timestamps in ns since epoch (see data_timestamp.h).
+    // The archive records the sample on its own queue, ahead of the merge.
+    bool updateSample(quint32 serieIndex, QTBTimestamp timestamp, QTBDataValue value)
     {
-        QMutexLocker locker(&mMutex);
-        mData.insert(serieIndex, QTBDataSample(timestamp, value));
+        if(mArchiveStream)
+            mArchiveStream->push(serieIndex, timestamp, value);
+        return mQueue.push(serieIndex, timestamp, value);
     }
 
+    // batch variants, the whole block is committed with a single synchronization
+    quint32 updateSamples(const QTBDataRecord *records, quint32 count)
+    {
+        if(mArchiveStream)
+            mArchiveStream->push(records, count);
+        return mQueue.push(records, count);
+    }
+
+    quint32 updateSamples(const QVector<QTBDataRecord>& records)
+    {
+        return updateSamples(records.constData(), quint32(records.count()));
+    }
+
+    // for sources which keep the samples the queue refused and offer them again: only the
+    // ones the queue took are archived, a retry doesn't record a sample twice
+    quint32 queueSamples(const QTBDataRecord *records, quint32 count)
+    {
+        const quint32 accepted = mQueue.push(records, count);
+        if(mArchiveStream && accepted)
+            mArchiveStream->push(records, accepted);
+        return accepted;
+    }
+
+    quint32 updateSamples(QTBTimestamp timestamp, const quint32 *serieIndexes, const QTBDataValue *values, quint32 count)
+    {
+        if(mArchiveStream)
+            mArchiveStream->push(timestamp, serieIndexes, values, count);
+        return mQueue.push(timestamp, serieIndexes, values, count);
+    }
+
+    quint32 queueSamples(QTBTimestamp timestamp, const quint32 *serieIndexes, const QTBDataValue *values, quint32 count)
+    {
+        const quint32 accepted = mQueue.push(timestamp, serieIndexes, values, count);
+        if(mArchiveStream && accepted)
+            mArchiveStream->push(timestamp, serieIndexes, values, accepted);
+        return accepted;
+    }
+
+    // straight to the archive, for sources loading recorded data; returns the number of samples taken,
+    // none when the queue of the archive is full or no archive is set
+    quint32 archiveSamples(QTBTimestamp timestamp, const quint32 *serieIndexes, const QTBDataValue *values, quint32 count)
+    {
+        return mArchiveStream ? mArchiveStream->push(timestamp, serieIndexes, values, count) : 0;
+    }
+
+    bool archiveEnabled() const { return mArchiveStream != nullptr; }
+
+    quint64 droppedSamples() const { return mQueue.overflowCount(); }
+    // merged samples the series dropped for coming too late, see SERIE_REORDER_WINDOW
+    quint64 lateSamples() const { return mLateSamples.loadAcquire(); }
+    quint32 pendingSamples() const { return mQueue.size(); }
+
     QString currentPath() { return mCurrentPath; }
 
     bool registerParameter(const QSharedPointer<QTBParameter>& param)
@@ -51,6 +112,21 @@ public:
             return false;
     }
 
+    // a single notification for the whole list, see QTBDataManager::registerParameters()
+    int registerParameters(const QList<QSharedPointer<QTBParameter>>& params)
+    {
+        if(mDataManager)
+            return mDataManager->registerParameters(params);
+        else
+            return 0;
+    }
+
+    void unregisterParameters(const QVector<quint32>& parameterIds)
+    {
+        if(mDataManager)
+            mDataManager->unregisterParameters(parameterIds);
+    }
+
     void unregisterParameter(quint32 parameterId)
     {
         if(mDataManager)
@@ -73,17 +149,26 @@ private:
         mDataManager = dataManager;
     }
 
-    void updateDashboardData()
+    void setArchiveStream(QTBDataArchiveStream *archiveStream)
     {
-        if(mStatus == dssRunning) {
-            QMutexLocker locker(&mMutex);
-            QHash<quint32, QTBDataSample>::iterator i;
-            for (i = mData.begin(); i != mData.end(); ++i) {
-                mDataManager->addSampleUnsafe(i.key(),
-                                              i.value().datationSec(),
-                                              i.value().value());
-            }
-        }
+        mArchiveStream = archiveStream;
+    }
+
+    void updateDashboardData(bool merge = true)
+    {
+        // samples still queued when the source stopped are flushed as well,
+        // those of unregistered parameters are ignored by the data buffer.
+        // During a replay they are dropped, the archive recorded them already.
+        QTBDataManager *dataManager = mDataManager;
+        quint64 late = 0;
+        mQueue.drain([dataManager, merge, &late](const QTBDataRecord& record) {
+            if(merge && !dataManager->addSample(record.serieIndex,
+                                                record.timestamp,
+                                                record.value))
+                late++;
+        });
+        if(late)
+            mLateSamples.fetchAndAddRelaxed(late);
     }
 
     void setStatus(const DataSourceStatus &status)
@@ -125,10 +210,11 @@ private:
     }
 
     QTBDataManager* mDataManager;
+    QTBDataArchiveStream *mArchiveStream;
     QString mCurrentPath;
     DataSourceStatus mStatus;
-    QMutex mMutex;
-    QHash<quint32, QTBDataSample> mData;
+    QTBDataSampleQueue mQueue;
+    QAtomicInteger<quint64> mLateSamples;
     bool mAutoStart;
 
     friend class QTBDataManager;
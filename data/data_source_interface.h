@@ -8,7 +8,7 @@ class DataSourceInterface : public DataSource
     Q_OBJECT
 public:
 
-    DataSourceInterface() : DataSource() {}
+    explicit DataSourceInterface(quint32 queueCapacity = SAMPLE_QUEUE_DEFAULT_CAPACITY) : DataSource(queueCapacity) {}
     virtual ~DataSourceInterface() {}
 
 protected:
@@ -0,0 +1,39 @@
+#ifndef DATA_TIMESTAMP_H
+#define DATA_TIMESTAMP_H
+
+#include <QtGlobal>
+#include <chrono>
+
+/* Sample timestamps: nanoseconds since the Unix epoch, UTC.
+ * They stay integers from the data sources to the data buffer, so that
+ * windows and comparisons are exact and don't wrap at midnight. They are
+ * converted to seconds, the unit of the plot keys, when drawn. */
+typedef qint64 QTBTimestamp;
+
+#define TIMESTAMP_NS_PER_SEC    Q_INT64_C(1000000000)
+#define TIMESTAMP_NS_PER_MSEC   Q_INT64_C(1000000)
+
+inline QTBTimestamp timestampNow()
+{
+    return QTBTimestamp(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+inline QTBTimestamp timestampFromMSecs(qint64 msecsSinceEpoch)
+{
+    return msecsSinceEpoch * TIMESTAMP_NS_PER_MSEC;
+}
+
+inline QTBTimestamp timestampFromSec(double secsSinceEpoch)
+{
+    return QTBTimestamp(secsSinceEpoch * double(TIMESTAMP_NS_PER_SEC));
+}
+
+// split in two so that the fraction keeps its nanoseconds
+inline double timestampToSec(QTBTimestamp timestamp)
+{
+    return double(timestamp / TIMESTAMP_NS_PER_SEC) +
+            double(timestamp % TIMESTAMP_NS_PER_SEC) / double(TIMESTAMP_NS_PER_SEC);
+}
+
+#endif // DATA_TIMESTAMP_H
@@ -5,6 +5,7 @@
 #include <QString>
 #include <cstdlib>
 #include <cmath>
+#include <limits>
 
 /* Classe de gestion des differents types informatiques*/
 struct s_int8 {
@@ -157,8 +158,57 @@ public:
         return 0;
     }
 
+    // the value in another type, integers saturate at the bounds of the type
+    QTBDataValue toType(ValueType type) {
+        if(type == mType)
+            return *this;
+
+        const double value = toDouble();
+        switch(type) {
+        case TYPE_FLOAT:
+            return QTBDataValue(float(value));
+        case TYPE_INT8:
+            return QTBDataValue(saturate<qint8>(value));
+        case TYPE_UINT8:
+            return QTBDataValue(saturate<quint8>(value));
+        case TYPE_INT16:
+            return QTBDataValue(saturate<qint16>(value));
+        case TYPE_UINT16:
+            return QTBDataValue(saturate<quint16>(value));
+        case TYPE_INT32:
+            return QTBDataValue(saturate<qint32>(value));
+        case TYPE_UINT32:
+            return QTBDataValue(saturate<quint32>(value));
+        }
+        return *this;
+    }
+
+    // number of significant bytes of mValue for a type
+    static int valueSize(ValueType type) {
+        switch(type) {
+        case TYPE_INT8:
+        case TYPE_UINT8:
+            return 1;
+        case TYPE_INT16:
+        case TYPE_UINT16:
+            return 2;
+        case TYPE_INT32:
+        case TYPE_UINT32:
+        case TYPE_FLOAT:
+            return 4;
+        }
+        return 4;
+    }
+
     u_data      mValue;
     ValueType   mType;
+
+private:
+    template <class T> static T saturate(double value) {
+        if(std::isnan(value))
+            return T(0);
+        return T(qBound(double(std::numeric_limits<T>::min()), value, double(std::numeric_limits<T>::max())));
+    }
 };
 
 #endif // DATAVALUE_H
@@ -0,0 +1,418 @@
+#include "csvdatasource.h"
+#include "3rdparty/csv.h"
+#include <QSettings>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QtConcurrent>
+
+CsvDataSource::CsvDataSource():
+    DataSourceInterface(),
+    mMode(cmStream),
+    mSeparator(','),
+    mHeader(true),
+    mTimeColumn(0),
+    mTimeUnit(ctuSecond),
+    mPeriod(TIMESTAMP_NS_PER_MSEC),
+    mTimeStart(0),
+    mSpeed(1.0),
+    mRebase(true),
+    mThreadCount(QThread::idealThreadCount()),
+    mRows(0),
+    mPosition(0),
+    mColumn(0),
+    mFirstRow(0),
+    mRowCount(0),
+    mSkippedRows(0),
+    mClockStarted(false),
+    mTimeOrigin(0),
+    mClockOrigin(0)
+{
+    setAutoStart(true);
+    mThread = new QThread(this);
+    mTimer = new QTimer(nullptr); // _not_ this!
+    mTimer->setTimerType(Qt::PreciseTimer);
+    mTimer->moveToThread(mThread);
+    connect(mTimer, SIGNAL(timeout()), SLOT(updateData()), Qt::DirectConnection);
+    mTimer->connect(mThread, SIGNAL(started()), SLOT(start()));
+    mTimer->connect(mThread, SIGNAL(finished()), SLOT(stop()));
+}
+
+CsvDataSource::~CsvDataSource()
+{
+    mThread->quit();
+    mThread->wait();
+    mTimer->deleteLater();
+    mThread->deleteLater();
+}
+
+bool CsvDataSource::startAcquisition()
+{
+    loadSettings();
+    if(mMode == cmArchive && !archiveEnabled()) {
+        qWarning() << "CsvDataSource: no archive to load" << mFileName << "into";
+        return false;
+    }
+    if(!openFile())
+        return false;
+
+    registerParameters();
+    // the archive mode reads as fast as the archive takes the samples
+    mTimer->setInterval(mMode == cmArchive ? 0 : CSV_STREAM_PERIOD_MS);
+    mThread->start();
+    return true;
+}
+
+bool CsvDataSource::stopAcquisition()
+{
+    mThread->quit();
+    mThread->wait();
+    if(mSkippedRows)
+        qWarning() << "CsvDataSource:" << mSkippedRows << "lines of" << mFileName << "skipped, their time can't be read";
+    unregisterParameters();
+    closeFile();
+    return true;
+}
+
+void CsvDataSource::loadSettings()
+{
+    QSettings settings(currentPath() + QDir::separator() + QString(CSV_SETTINGS_FILE), QSettings::IniFormat);
+
+    mFileName = settings.value(QString("File")).toString();
+    mMode = settings.value(QString("Mode"), QString("stream")).toString() == QString("archive") ? cmArchive : cmStream;
+    QString separator = settings.value(QString("Separator"), QString(",")).toString();
+    if(separator == QString("\\t"))
+        separator = QString("\t");
+    mSeparator = separator.isEmpty() ? ',' : separator.at(0).toLatin1();
+    mHeader = settings.value(QString("Header"), true).toBool();
+    mTimeColumn = settings.value(QString("TimeColumn"), 0).toInt();
+    mPeriod = qMax(Q_INT64_C(1), qint64(settings.value(QString("Period"), 1.0).toDouble() * TIMESTAMP_NS_PER_MSEC));
+    mSpeed = qMax(0.001, settings.value(QString("Speed"), 1.0).toDouble());
+    mRebase = settings.value(QString("Rebase"), true).toBool();
+    mThreadCount = qMax(1, settings.value(QString("Threads"), QThread::idealThreadCount()).toInt());
+
+    QString unit = settings.value(QString("TimeUnit"), QString("s")).toString();
+    if(unit == QString("ms"))
+        mTimeUnit = ctuMillisecond;
+    else if(unit == QString("us"))
+        mTimeUnit = ctuMicrosecond;
+    else if(unit == QString("ns"))
+        mTimeUnit = ctuNanosecond;
+    else if(unit == QString("iso"))
+        mTimeUnit = ctuIso;
+    else
+        mTimeUnit = ctuSecond;
+}
+
+bool CsvDataSource::openFile()
+{
+    closeFile();
+
+    QStringList labels;
+    try {
+        mReader.reset(new io::LineReader(mFileName.toStdString()));
+
+        char *line = mReader->next_line();
+        if(!line) {
+            qWarning() << "CsvDataSource: empty file" << mFileName;
+            closeFile();
+            return false;
+        }
+        labels = QString::fromUtf8(line).split(QChar(mSeparator));
+        if(!mHeader) {
+            // the first line is data, read it again
+            mReader.reset(new io::LineReader(mFileName.toStdString()));
+            for(int i = 0; i < labels.count(); i++)
+                labels[i] = QString("COLUMN_%1").arg(i);
+        }
+    } catch(const io::error::base &error) {
+        qWarning() << "CsvDataSource:" << error.what();
+        closeFile();
+        return false;
+    }
+
+    const QString sourceName = QFileInfo(mFileName).completeBaseName();
+    mListParam.clear();
+    mFieldColumns.resize(labels.count());
+    for(int i = 0; i < labels.count(); i++) {
+        if(i == mTimeColumn) {
+            mFieldColumns[i] = -1;
+            continue;
+        }
+
+        QString label = labels.at(i).trimmed();
+        if(label.startsWith('"') && label.endsWith('"') && label.size() >= 2)
+            label = label.mid(1, label.size() - 2);
+
+        QSharedPointer<QTBParameter> param = QSharedPointer<QTBParameter>(new QTBParameter());
+        param->setLabel(label);
+        param->setSourceName(sourceName);
+        mFieldColumns[i] = mListParam.count();
+        mListParam.append(param);
+    }
+
+    mRows = 0;
+    mPosition = 0;
+    mColumn = 0;
+    mFirstRow = 0;
+    mRowCount = 0;
+    mSkippedRows = 0;
+    mTimeStart = timestampNow();
+    mClockStarted = false;
+    return !mListParam.isEmpty();
+}
+
+void CsvDataSource::closeFile()
+{
+    mReader.reset();
+    mText.clear();
+    mLines.clear();
+    mRows = 0;
+    mPosition = 0;
+    mColumn = 0;
+}
+
+void CsvDataSource::registerParameters()
+{
+    DataSource::registerParameters(mListParam);
+
+    mSerieIndexes.resize(mListParam.count());
+    for (int j = 0; j < mListParam.count(); ++j)
+        mSerieIndexes[j] = mListParam.at(j)->parameterId();
+}
+
+void CsvDataSource::unregisterParameters()
+{
+    DataSource::unregisterParameters(mSerieIndexes);
+}
+
+void CsvDataSource::updateData()
+{
+    if(mMode == cmArchive)
+        archiveRows();
+    else
+        streamRows();
+}
+
+bool CsvDataSource::readBatch()
+{
+    mText.resize(0);
+    mLines.resize(0);
+    mRows = 0;
+    mPosition = 0;
+    mColumn = 0;
+    if(!mReader)
+        return false;
+
+    // the reader reuses its buffer, the lines of the batch are copied
+    try {
+        char *line;
+        while(mLines.count() < CSV_BATCH_ROWS && (line = mReader->next_line()) != nullptr) {
+            const int length = int(strlen(line));
+            if(length == 0)
+                continue;
+            mLines.append(mText.size());
+            mText.append(line, length + 1);
+        }
+    } catch(const io::error::base &error) {
+        qWarning() << "CsvDataSource:" << error.what();
+        mReader.reset();
+    }
+
+    mRows = mLines.count();
+    if(mRows == 0) {
+        closeFile();
+        return false;
+    }
+
+    const int columns = mSerieIndexes.count();
+    mTimestamps.resize(mRows);
+    mValues.resize(mRows * columns);
+    mFirstRow = mRowCount;
+    mRowCount += mRows;
+
+    // rows are split in slices parsed in parallel, each one writes its own rows
+    const int sliceRows = qMax(CSV_SLICE_MIN_ROWS, mRows / mThreadCount + 1);
+    QVector<QPair<int, int>> slices;
+    for(int begin = 0; begin < mRows; begin += sliceRows)
+        slices.append(qMakePair(begin, qMin(mRows, begin + sliceRows)));
+
+    if(slices.count() == 1) {
+        parseRows(0, mRows);
+    } else {
+        QtConcurrent::blockingMap(slices, [this](const QPair<int, int> &slice) {
+            parseRows(slice.first, slice.second);
+        });
+    }
+
+    // lines without a valid time are left out of the batch
+    int kept = 0;
+    for(int row = 0; row < mRows; row++) {
+        if(mTimestamps.at(row) == CSV_INVALID_TIMESTAMP) {
+            mSkippedRows++;
+            continue;
+        }
+        if(kept != row) {
+            mTimestamps[kept] = mTimestamps.at(row);
+            memcpy(mValues.data() + kept * columns, mValues.constData() + row * columns, size_t(columns) * sizeof(QTBDataValue));
+        }
+        kept++;
+    }
+    mRows = kept;
+    return true;
+}
+
+void CsvDataSource::parseRows(int begin, int end)
+{
+    const int columns = mSerieIndexes.count();
+    const int fields = mFieldColumns.count();
+    const char separator = mSeparator;
+    const QTBDataValue missing(float(qQNaN()));
+
+    for(int row = begin; row < end; row++) {
+        char *field = mText.data() + mLines.at(row);
+        QTBDataValue *values = mValues.data() + row * columns;
+        QTBTimestamp timestamp = mTimeColumn < 0 ? parseTimestamp(nullptr, mFirstRow + row) : CSV_INVALID_TIMESTAMP;
+
+        for(int column = 0; column < columns; column++)
+            values[column] = missing;
+
+        for(int index = 0; index < fields && field; index++) {
+            // cut the field in place, the batch text is ours
+            char *next = strchr(field, separator);
+            if(next)
+                *next++ = '\0';
+
+            while(*field == ' ' || *field == '"')
+                field++;
+            char *last = field + strlen(field);
+            while(last > field && (last[-1] == ' ' || last[-1] == '"'))
+                *--last = '\0';
+
+            const int column = mFieldColumns.at(index);
+            if(column < 0) {
+                timestamp = parseTimestamp(field, mFirstRow + row);
+            } else if(*field) {
+                try {
+                    float value;
+                    io::detail::parse_float(field, value);
+                    values[column] = QTBDataValue(value);
+                } catch(const io::error::base &) {
+                }
+            }
+            field = next;
+        }
+
+        mTimestamps[row] = timestamp;
+    }
+}
+
+QTBTimestamp CsvDataSource::parseTimestamp(const char *field, qint64 row) const
+{
+    if(!field)
+        return mTimeStart + row * mPeriod;
+
+    if(mTimeUnit == ctuIso) {
+        QDateTime time = QDateTime::fromString(QString::fromLatin1(field), Qt::ISODateWithMs);
+        if(!time.isValid())
+            return CSV_INVALID_TIMESTAMP;
+        return timestampFromMSecs(time.toMSecsSinceEpoch());
+    }
+
+    qint64 scale = TIMESTAMP_NS_PER_SEC;
+    if(mTimeUnit == ctuMillisecond)
+        scale = TIMESTAMP_NS_PER_MSEC;
+    else if(mTimeUnit == ctuMicrosecond)
+        scale = 1000;
+    else if(mTimeUnit == ctuNanosecond)
+        scale = 1;
+
+    // integer and decimal parts apart, a double would round epoch nanoseconds
+    bool negative = false;
+    if(*field == '-' || *field == '+')
+        negative = *field++ == '-';
+
+    const char *digits = field;
+    qint64 integer = 0;
+    while(*field >= '0' && *field <= '9')
+        integer = integer * 10 + (*field++ - '0');
+
+    qint64 fraction = 0;
+    if(*field == '.') {
+        field++;
+        qint64 digitScale = scale;
+        while(*field >= '0' && *field <= '9') {
+            digitScale /= 10;
+            fraction += (*field++ - '0') * digitScale;
+        }
+    }
+
+    // an empty field, or one that is not a number
+    if(*field || field == digits || (field == digits + 1 && *digits == '.'))
+        return CSV_INVALID_TIMESTAMP;
+
+    const QTBTimestamp timestamp = integer * scale + fraction;
+    return negative ? -timestamp : timestamp;
+}
+
+void CsvDataSource::streamRows()
+{
+    const QTBTimestamp now = timestampNow();
+    const quint32 columns = quint32(mSerieIndexes.count());
+
+    forever {
+        if(mPosition == mRows && !readBatch()) {
+            mTimer->stop();
+            return;
+        }
+
+        const QTBTimestamp timestamp = mTimestamps.at(mPosition);
+        if(!mClockStarted) {
+            mClockStarted = true;
+            mTimeOrigin = timestamp;
+            mClockOrigin = now;
+        }
+
+        // lines are played at the pace of the file, scaled by the speed
+        const QTBTimestamp due = mClockOrigin + QTBTimestamp(double(timestamp - mTimeOrigin) / mSpeed);
+        if(due > now)
+            return;
+
+        // what the full queue refuses is offered again on the next tick, it is archived once taken
+        const quint32 pending = columns - quint32(mColumn);
+        const quint32 accepted = queueSamples(mRebase ? due : timestamp,
+                                              mSerieIndexes.constData() + mColumn,
+                                              mValues.constData() + mPosition * int(columns) + mColumn,
+                                              pending);
+        if(accepted < pending) {
+            mColumn += int(accepted);
+            return;
+        }
+        mColumn = 0;
+        mPosition++;
+    }
+}
+
+void CsvDataSource::archiveRows()
+{
+    if(mPosition == mRows && !readBatch()) {
+        mTimer->stop();
+        qDebug() << "CsvDataSource:" << mRowCount << "lines of" << mFileName << "archived";
+        return;
+    }
+
+    // the archive queue is waited for, a bulk load drops nothing
+    const quint32 columns = quint32(mSerieIndexes.count());
+    for(; mPosition < mRows; mPosition++) {
+        const QTBDataValue *values = mValues.constData() + mPosition * int(columns);
+        quint32 pushed = 0;
+        while(pushed < columns) {
+            quint32 accepted = archiveSamples(mTimestamps.at(mPosition),
+                                              mSerieIndexes.constData() + pushed,
+                                              values + pushed,
+                                              columns - pushed);
+            if(accepted == 0)
+                QThread::msleep(1);
+            pushed += accepted;
+        }
+    }
+}
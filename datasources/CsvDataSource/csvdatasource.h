@@ -0,0 +1,120 @@
+#ifndef CSVDATASOURCE_H
+#define CSVDATASOURCE_H
+
+#include <QtPlugin>
+#include <QThread>
+#include <QTimer>
+#include <memory>
+#include <limits>
+#include "data/data_source_interface.h"
+
+#define CSV_SETTINGS_FILE "csvdatasource.ini"
+#define CSV_BATCH_ROWS 65536
+#define CSV_SLICE_MIN_ROWS 1024
+#define CSV_STREAM_PERIOD_MS 10
+// time of a line whose time field can't be read
+#define CSV_INVALID_TIMESTAMP std::numeric_limits<qint64>::min()
+
+namespace io { class LineReader; }
+
+/* Loads a CSV log, one parameter per column. The settings are read from
+ * csvdatasource.ini next to the plugin:
+ *   File           path of the log
+ *   Mode           stream: played at the pace of its timestamps
+ *                  archive: written to the archive as fast as it is read
+ *   Separator      field separator, ',' by default
+ *   Header         the first line holds the labels, true by default
+ *   TimeColumn     index of the time column, -1 when there is none
+ *   TimeUnit       s, ms, us, ns since epoch or iso (ISO 8601 date)
+ *   Period         ms between two lines when there is no time column,
+ *                  the first line is then dated when the file is opened
+ *   Speed          stream mode, playback speed
+ *   Rebase         stream mode, timestamps shifted to the current time
+ *   Threads        parsing threads, the number of cores by default
+ * The file is read ahead by blocks on a separate thread, lines are parsed
+ * by batches split over the parsing threads. Lines whose time can't be
+ * read are skipped and counted. Quoted fields holding the separator are
+ * not supported. */
+class CsvDataSource: public DataSourceInterface
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID DataSourceInterface_iid FILE "csvdatasource.json")
+    Q_INTERFACES(DataSourceInterface)
+
+public:
+    enum CsvMode {
+        cmStream,
+        cmArchive
+    };
+
+    enum CsvTimeUnit {
+        ctuSecond,
+        ctuMillisecond,
+        ctuMicrosecond,
+        ctuNanosecond,
+        ctuIso
+    };
+
+    CsvDataSource();
+    ~CsvDataSource() override;
+
+    bool startAcquisition() override;
+    bool stopAcquisition() override;
+
+    void loadSettings();
+    bool openFile();
+    void registerParameters();
+    void unregisterParameters();
+
+public slots:
+    void updateData();
+
+protected:
+    bool readBatch();
+    void parseRows(int begin, int end);
+    QTBTimestamp parseTimestamp(const char *field, qint64 row) const;
+    void streamRows();
+    void archiveRows();
+    void closeFile();
+
+    QThread *mThread;
+    QTimer *mTimer;
+
+    QString mFileName;
+    CsvMode mMode;
+    char mSeparator;
+    bool mHeader;
+    int mTimeColumn;
+    CsvTimeUnit mTimeUnit;
+    QTBTimestamp mPeriod;
+    QTBTimestamp mTimeStart;
+    double mSpeed;
+    bool mRebase;
+    int mThreadCount;
+
+    std::unique_ptr<io::LineReader> mReader;
+    QList<QSharedPointer<QTBParameter>> mListParam;
+    QVector<quint32> mSerieIndexes;
+    // field index to value column, -1 for the time column
+    QVector<int> mFieldColumns;
+
+    // current batch, values are row major
+    QByteArray mText;
+    QVector<int> mLines;
+    QVector<QTBTimestamp> mTimestamps;
+    QVector<QTBDataValue> mValues;
+    int mRows;
+    int mPosition;
+    // values of the row at mPosition already queued, the rest is offered again
+    int mColumn;
+    qint64 mFirstRow;
+    qint64 mRowCount;
+    qint64 mSkippedRows;
+
+    // stream mode clock
+    bool mClockStarted;
+    QTBTimestamp mTimeOrigin;
+    QTBTimestamp mClockOrigin;
+};
+
+#endif // CSVDATASOURCE_H
@@ -40,9 +40,11 @@ include($$PROJECT_ROOT_DIRECTORY/data/data.pri)
 
 SOURCES += \
         demodatasource.cpp \
+        demogenerator.cpp \
         demoparameter.cpp
 
 HEADERS += \
         demodatasource.h \
+        demogenerator.h \
         demoparameter.h
 
@@ -27,8 +27,8 @@ DemoDataSource::~DemoDataSource()
 
 bool DemoDataSource::startAcquisition()
 {    
-    mThread->start();
     registerParameters();
+    mThread->start();
     return true;
 }
 
@@ -142,26 +142,33 @@ void DemoDataSource::loadParameters()
 
 void DemoDataSource::registerParameters()
 {
-    QList<QSharedPointer<DemoParameter>>::iterator i;
-    for (i = mListParam.begin(); i != mListParam.end(); ++i) {
-        registerParameter((*i));
-    }
+    QList<QSharedPointer<QTBParameter>> params;
+    params.reserve(mListParam.count());
+    for (const QSharedPointer<DemoParameter> &param : mListParam)
+        params.append(param);
+    DataSource::registerParameters(params);
+
+    mGenerator.build(mListParam);
+    mSerieIndexes.resize(mGenerator.count());
+    mValues.resize(mGenerator.count());
+    for (int j = 0; j < mGenerator.count(); ++j)
+        mSerieIndexes[j] = mListParam.at(mGenerator.order().at(j))->parameterId();
 }
 
 void DemoDataSource::unregisterParameters()
 {
-    QList<QSharedPointer<DemoParameter>>::iterator i;
-    for (i = mListParam.begin(); i != mListParam.end(); ++i)
-        unregisterParameter((*i)->parameterId());
+    DataSource::unregisterParameters(mSerieIndexes);
 }
 
 void DemoDataSource::updateData()
 {
-    double timestamp = QDateTime::currentDateTimeUtc().time().msecsSinceStartOfDay() / 1000.0;
-    QList<QSharedPointer<DemoParameter>>::iterator i;
-    for (i = mListParam.begin(); i != mListParam.end(); ++i) {
-        updateSample((*i)->parameterId(),
-                     timestamp,
-                     (*i)->updateParameter(timestamp));
-    }
+    QTBTimestamp timestamp = timestampNow();
+    // the generators take a small time, qRound() would overflow on epoch seconds
+    double timeSec = timestampToSec(timestamp % (86400 * TIMESTAMP_NS_PER_SEC));
+    mGenerator.generate(timeSec, mValues.data());
+
+    updateSamples(timestamp,
+                  mSerieIndexes.constData(),
+                  mValues.constData(),
+                  quint32(mValues.count()));
 }
@@ -6,6 +6,7 @@
 #include <QTimer>
 #include "data/data_source_interface.h"
 #include "demoparameter.h"
+#include "demogenerator.h"
 
 class DemoDataSource: public DataSourceInterface
 {
@@ -31,6 +32,10 @@ protected:
     QThread *mThread;
     QTimer *mTimer;
     QList<QSharedPointer<DemoParameter>> mListParam;
+    DemoGenerator mGenerator;
+    // in the order of the generator
+    QVector<quint32> mSerieIndexes;
+    QVector<QTBDataValue> mValues;
 };
 
 #endif // DEMODATASOURCE_H
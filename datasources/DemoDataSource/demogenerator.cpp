@@ -0,0 +1,145 @@
+#include "demogenerator.h"
+#include <cmath>
+#include <limits>
+
+void DemoGenerator::build(const QList<QSharedPointer<DemoParameter>> &parameters)
+{
+    mGroups.clear();
+    mOrder.clear();
+
+    // one group per generator and value type, in the order they first appear
+    QVector<QVector<int>> members;
+    for(int i = 0; i < parameters.count(); i++) {
+        const DemoParameter *parameter = parameters.at(i).data();
+        int group = 0;
+        while(group < mGroups.count()
+              && (mGroups.at(group).generatorType != parameter->generatorType()
+                  || mGroups.at(group).valueType != parameter->valueType()))
+            group++;
+        if(group == mGroups.count()) {
+            Group newGroup;
+            newGroup.generatorType = parameter->generatorType();
+            newGroup.valueType = parameter->valueType();
+            mGroups.append(newGroup);
+            members.append(QVector<int>());
+        }
+
+        Group &target = mGroups[group];
+        target.frequency.append(parameter->signalFrequency());
+        target.phase.append(parameter->signalPhase());
+        target.amplitude.append(parameter->signalAmplitude());
+        target.offset.append(parameter->signalOffset());
+        members[group].append(i);
+    }
+
+    int largest = 0;
+    for(int group = 0; group < mGroups.count(); group++) {
+        mOrder += members.at(group);
+        largest = qMax(largest, members.at(group).count());
+    }
+    mTime.resize(largest);
+    mCycles.resize(largest);
+    mWave.resize(largest);
+}
+
+void DemoGenerator::generate(double timeSec, QTBDataValue *values)
+{
+    double *t = mTime.data();
+    float *cycles = mCycles.data();
+    float *wave = mWave.data();
+
+    for(const Group &group : mGroups) {
+        const int count = group.frequency.count();
+        const double *frequency = group.frequency.constData();
+        const double *phase = group.phase.constData();
+        const float *amplitude = group.amplitude.constData();
+        const float *offset = group.offset.constData();
+
+        // same time base as DemoParameter::updateValue()
+        for(int i = 0; i < count; i++)
+            t[i] = frequency[i] * timeSec + phase[i];
+
+        switch(group.generatorType) {
+        case DemoParameter::gtSine:
+        case DemoParameter::gtSquare:
+            // the fraction of the cycle is taken in double, the rest fits a float
+            for(int i = 0; i < count; i++)
+                cycles[i] = float(t[i] - std::floor(t[i]));
+            if(group.generatorType == DemoParameter::gtSine)
+                sine(cycles, wave, count);
+            else
+                square(cycles, wave, count);
+            break;
+        case DemoParameter::gtTriangle:
+            triangle(t, wave, count);
+            break;
+        case DemoParameter::gtSawtooth:
+            sawtooth(t, wave, count);
+            break;
+        }
+
+        for(int i = 0; i < count; i++)
+            wave[i] = amplitude[i] * wave[i] + offset[i];
+
+        switch(group.valueType) {
+        case QTBDataValue::TYPE_INT8: convert<qint8>(wave, values, count); break;
+        case QTBDataValue::TYPE_UINT8: convert<quint8>(wave, values, count); break;
+        case QTBDataValue::TYPE_INT16: convert<qint16>(wave, values, count); break;
+        case QTBDataValue::TYPE_UINT16: convert<quint16>(wave, values, count); break;
+        case QTBDataValue::TYPE_INT32: convert<qint32>(wave, values, count); break;
+        case QTBDataValue::TYPE_UINT32: convert<quint32>(wave, values, count); break;
+        case QTBDataValue::TYPE_FLOAT:
+            for(int i = 0; i < count; i++)
+                values[i] = QTBDataValue(wave[i]);
+            break;
+        }
+        values += count;
+    }
+}
+
+void DemoGenerator::sine(const float *cycles, float *wave, int count)
+{
+    for(int i = 0; i < count; i++) {
+        // cycle fraction folded on [-0.25, 0.25], then the Taylor series of
+        // sin up to x^11: within 3e-7 of qSin()
+        float y = cycles[i] >= 0.5f ? cycles[i] - 1.0f : cycles[i];
+        y = y > 0.25f ? 0.5f - y : y;
+        y = y < -0.25f ? -0.5f - y : y;
+        const float x = float(2.0 * M_PI) * y;
+        const float x2 = x * x;
+        wave[i] = x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f
+                  + x2 * (1.0f / 362880.0f + x2 * (-1.0f / 39916800.0f))))));
+    }
+}
+
+void DemoGenerator::square(const float *cycles, float *wave, int count)
+{
+    // sign of the sine, nil on its zeros
+    for(int i = 0; i < count; i++)
+        wave[i] = cycles[i] == 0.0f || cycles[i] == 0.5f ? 0.0f : (cycles[i] < 0.5f ? 1.0f : -1.0f);
+}
+
+void DemoGenerator::triangle(const double *t, float *wave, int count)
+{
+    // qRound(x) is floor(x + 0.5)
+    for(int i = 0; i < count; i++) {
+        const double x = t[i] - 0.25;
+        wave[i] = float(1.0 - 4.0 * std::fabs(std::floor(x + 0.5) - x));
+    }
+}
+
+void DemoGenerator::sawtooth(const double *t, float *wave, int count)
+{
+    for(int i = 0; i < count; i++)
+        wave[i] = float(2.0 * (t[i] - std::floor(t[i] + 0.5)));
+}
+
+template<typename T>
+void DemoGenerator::convert(const float *value, QTBDataValue *values, int count)
+{
+    // saturated as safeTypeConversion() does, bounds compared in double
+    const double low = double(std::numeric_limits<T>::min());
+    const double high = double(std::numeric_limits<T>::max());
+    for(int i = 0; i < count; i++)
+        values[i] = QTBDataValue(T(qBound(low, double(value[i]), high)));
+}
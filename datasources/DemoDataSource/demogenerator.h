@@ -0,0 +1,52 @@
+#ifndef DEMOGENERATOR_H
+#define DEMOGENERATOR_H
+
+#include <QVector>
+#include <QList>
+#include <QSharedPointer>
+#include "demoparameter.h"
+
+/* Batched DemoParameter::updateParameter(): the parameters are grouped by
+ * generator and value type, their settings kept in arrays. A group is
+ * computed in three plain loops, the waveform, the scaling and the
+ * conversion, with no call or switch per parameter; the sine is a
+ * polynomial the compiler can vectorize. Values come out in group order,
+ * see order(). */
+class DemoGenerator
+{
+public:
+    void build(const QList<QSharedPointer<DemoParameter>> &parameters);
+
+    // index in the list given to build() of each generated value
+    const QVector<int> &order() const { return mOrder; }
+    int count() const { return mOrder.count(); }
+
+    void generate(double timeSec, QTBDataValue *values);
+
+private:
+    struct Group
+    {
+        DemoParameter::GeneratorType generatorType;
+        QTBDataValue::ValueType valueType;
+        QVector<double> frequency;
+        QVector<double> phase;
+        QVector<float> amplitude;
+        QVector<float> offset;
+    };
+
+    static void sine(const float *cycles, float *wave, int count);
+    static void square(const float *cycles, float *wave, int count);
+    static void triangle(const double *t, float *wave, int count);
+    static void sawtooth(const double *t, float *wave, int count);
+    template<typename T> static void convert(const float *value, QTBDataValue *values, int count);
+
+    QVector<Group> mGroups;
+    QVector<int> mOrder;
+
+    // scratch of the largest group
+    QVector<double> mTime;
+    QVector<float> mCycles;
+    QVector<float> mWave;
+};
+
+#endif // DEMOGENERATOR_H
@@ -0,0 +1,249 @@
+#include "loaddatasource.h"
+#include <QSettings>
+#include <QtMath>
+
+LoadDataSource::LoadDataSource():
+    DataSourceInterface(LOAD_QUEUE_CAPACITY),
+    mSeed(1),
+    mRandom(1),
+    mStart(0),
+    mLast(0),
+    mGenerated(0),
+    mRecordCount(0)
+{
+    setAutoStart(true);
+    mThread = new QThread(this);
+    mTimer = new QTimer(nullptr); // _not_ this!
+    mTimer->setInterval(LOAD_DEFAULT_PERIOD_MS);
+    mTimer->setTimerType(Qt::PreciseTimer);
+    mTimer->moveToThread(mThread);
+    connect(mTimer, SIGNAL(timeout()), SLOT(updateData()), Qt::DirectConnection);
+    mTimer->connect(mThread, SIGNAL(started()), SLOT(start()));
+    mTimer->connect(mThread, SIGNAL(finished()), SLOT(stop()));
+}
+
+LoadDataSource::~LoadDataSource()
+{
+    mThread->quit();
+    mThread->wait();
+    mTimer->deleteLater();
+    mThread->deleteLater();
+}
+
+bool LoadDataSource::startAcquisition()
+{
+    loadSettings();
+    if(mGroups.isEmpty()) {
+        qWarning() << "LoadDataSource: no group set in" << LOAD_SETTINGS_FILE;
+        return false;
+    }
+
+    registerParameters();
+    mRandom = mSeed ? mSeed : 1;
+    mStart = mLast = timestampNow();
+    mGenerated = 0;
+    mRecordCount = 0;
+    mThread->start();
+    return true;
+}
+
+bool LoadDataSource::stopAcquisition()
+{
+    mThread->quit();
+    mThread->wait();
+    qDebug() << "LoadDataSource:" << mGenerated << "samples generated," << droppedSamples() << "dropped by the queue,"
+             << lateSamples() << "too late";
+    unregisterParameters();
+    return true;
+}
+
+void LoadDataSource::loadSettings()
+{
+    QSettings settings(currentPath() + QDir::separator() + QString(LOAD_SETTINGS_FILE), QSettings::IniFormat);
+
+    mTimer->setInterval(qMax(1, settings.value(QString("Period"), LOAD_DEFAULT_PERIOD_MS).toInt()));
+    mSeed = settings.value(QString("Seed"), 1).toULongLong();
+
+    mGroups.clear();
+    int parameters = 0;
+    const int groupCount = settings.beginReadArray(QString("Groups"));
+    for(int i = 0; i < groupCount; i++) {
+        settings.setArrayIndex(i);
+        LoadGroup group;
+        group.prefix = settings.value(QString("Prefix"), QString("LOAD%1").arg(i)).toString();
+        group.count = qBound(0, settings.value(QString("Count"), 100).toInt(), LOAD_MAX_PARAMETERS - parameters);
+        group.rate = qBound(0.001, settings.value(QString("Rate"), 10.0).toDouble(), 1e6);
+
+        const QString type = settings.value(QString("Type"), QString("float")).toString();
+        if(type == QString("int8"))
+            group.type = QTBDataValue::TYPE_INT8;
+        else if(type == QString("uint8"))
+            group.type = QTBDataValue::TYPE_UINT8;
+        else if(type == QString("int16"))
+            group.type = QTBDataValue::TYPE_INT16;
+        else if(type == QString("uint16"))
+            group.type = QTBDataValue::TYPE_UINT16;
+        else if(type == QString("int32"))
+            group.type = QTBDataValue::TYPE_INT32;
+        else if(type == QString("uint32"))
+            group.type = QTBDataValue::TYPE_UINT32;
+        else
+            group.type = QTBDataValue::TYPE_FLOAT;
+
+        const QString waveform = settings.value(QString("Waveform"), QString("sine")).toString();
+        if(waveform == QString("square"))
+            group.waveform = LoadGroup::lwSquare;
+        else if(waveform == QString("triangle"))
+            group.waveform = LoadGroup::lwTriangle;
+        else if(waveform == QString("sawtooth"))
+            group.waveform = LoadGroup::lwSawtooth;
+        else if(waveform == QString("random"))
+            group.waveform = LoadGroup::lwRandom;
+        else
+            group.waveform = LoadGroup::lwSine;
+
+        group.frequency = settings.value(QString("Frequency"), 0.1).toDouble();
+        group.amplitude = settings.value(QString("Amplitude"), 100.0).toFloat();
+        group.offset = settings.value(QString("Offset"), 0.0).toFloat();
+        group.jitter = qBound(0.0, settings.value(QString("Jitter"), 0.0).toDouble(), 1.0);
+        group.burstPeriod = qMax(0.0, settings.value(QString("BurstPeriod"), 0.0).toDouble());
+        group.burstLength = qMax(0.0, settings.value(QString("BurstLength"), 0.0).toDouble());
+        group.burstFactor = qMax(0.0, settings.value(QString("BurstFactor"), 1.0).toDouble());
+        group.outOfOrder = qBound(0.0, settings.value(QString("OutOfOrder"), 0.0).toDouble(), 1.0);
+        group.outOfOrderDelay = qint64(settings.value(QString("OutOfOrderDelay"), 100.0).toDouble() * TIMESTAMP_NS_PER_MSEC);
+        group.emitted = 0;
+        group.position = 0.0;
+        group.firstSerie = 0;
+
+        if(group.count > 0) {
+            parameters += group.count;
+            mGroups.append(group);
+        }
+    }
+    settings.endArray();
+}
+
+void LoadDataSource::registerParameters()
+{
+    mListParam.clear();
+    for(LoadGroup &group : mGroups) {
+        group.firstSerie = mListParam.count();
+        for(int i = 0; i < group.count; i++) {
+            QSharedPointer<QTBParameter> param = QSharedPointer<QTBParameter>(new QTBParameter());
+            param->setLabel(QString("%1_%2").arg(group.prefix).arg(i));
+            param->setSourceName(QString("LOAD/") + group.prefix);
+            mListParam.append(param);
+        }
+    }
+
+    DataSource::registerParameters(mListParam);
+    mSerieIndexes.resize(mListParam.count());
+    for(int i = 0; i < mListParam.count(); i++)
+        mSerieIndexes[i] = mListParam.at(i)->parameterId();
+}
+
+void LoadDataSource::unregisterParameters()
+{
+    DataSource::unregisterParameters(mSerieIndexes);
+}
+
+void LoadDataSource::updateData()
+{
+    const QTBTimestamp now = timestampNow();
+    if(now <= mLast)
+        return;
+
+    const double elapsedSec = double(mLast - mStart) / TIMESTAMP_NS_PER_SEC;
+    for(LoadGroup &group : mGroups)
+        generate(group, mLast, now, elapsedSec);
+    flush();
+    mLast = now;
+}
+
+double LoadDataSource::burstFactor(const LoadGroup &group, double elapsedSec) const
+{
+    if(group.burstPeriod <= 0.0)
+        return 1.0;
+    return std::fmod(elapsedSec, group.burstPeriod) < group.burstLength ? group.burstFactor : 1.0;
+}
+
+void LoadDataSource::generate(LoadGroup &group, QTBTimestamp begin, QTBTimestamp end, double elapsedSec)
+{
+    // the parameters are staggered: the samples due over the pass are spread on it
+    group.position += double(group.count) * group.rate * burstFactor(group, elapsedSec)
+            * double(end - begin) / TIMESTAMP_NS_PER_SEC;
+    const quint64 due = quint64(group.position);
+    if(due <= group.emitted)
+        return;
+
+    const quint64 count = due - group.emitted;
+    const double step = double(end - begin) / double(count);
+    const double period = TIMESTAMP_NS_PER_SEC / group.rate;
+    int parameter = int(group.emitted % quint64(group.count));
+
+    for(quint64 k = 0; k < count; k++) {
+        QTBTimestamp timestamp = begin + QTBTimestamp(step * double(k + 1));
+        if(group.jitter > 0.0)
+            timestamp += QTBTimestamp((2.0 * uniform() - 1.0) * group.jitter * period);
+        if(group.outOfOrder > 0.0 && uniform() < group.outOfOrder)
+            timestamp -= QTBTimestamp(uniform() * double(group.outOfOrderDelay));
+
+        QTBDataRecord &record = mRecords[mRecordCount];
+        record.serieIndex = mSerieIndexes.at(group.firstSerie + parameter);
+        record.timestamp = timestamp;
+        record.value = value(group, parameter, double(timestamp - mStart) / TIMESTAMP_NS_PER_SEC);
+        if(++mRecordCount == LOAD_BATCH_RECORDS)
+            flush();
+
+        if(++parameter == group.count)
+            parameter = 0;
+    }
+    group.emitted = due;
+}
+
+QTBDataValue LoadDataSource::value(const LoadGroup &group, int parameter, double timeSec)
+{
+    // a phase of its own for each parameter, from the golden ratio
+    const double phase = std::fmod(parameter * 0.6180339887498949, 1.0);
+    const double t = group.frequency * timeSec + phase;
+
+    double wave = 0.0;
+    switch(group.waveform) {
+    case LoadGroup::lwSine:
+        wave = qSin(2.0 * M_PI * t);
+        break;
+    case LoadGroup::lwSquare:
+        wave = t - qFloor(t) < 0.5 ? 1.0 : -1.0;
+        break;
+    case LoadGroup::lwTriangle:
+        wave = 1.0 - 4.0 * qAbs(qFloor(t - 0.25 + 0.5) - (t - 0.25));
+        break;
+    case LoadGroup::lwSawtooth:
+        wave = 2.0 * (t - qFloor(t + 0.5));
+        break;
+    case LoadGroup::lwRandom:
+        wave = 2.0 * uniform() - 1.0;
+        break;
+    }
+
+    const double v = double(group.offset) + double(group.amplitude) * wave;
+    switch(group.type) {
+    case QTBDataValue::TYPE_INT8: return QTBDataValue(qint8(qBound(-128.0, v, 127.0)));
+    case QTBDataValue::TYPE_UINT8: return QTBDataValue(quint8(qBound(0.0, v, 255.0)));
+    case QTBDataValue::TYPE_INT16: return QTBDataValue(qint16(qBound(-32768.0, v, 32767.0)));
+    case QTBDataValue::TYPE_UINT16: return QTBDataValue(quint16(qBound(0.0, v, 65535.0)));
+    case QTBDataValue::TYPE_INT32: return QTBDataValue(qint32(qBound(-2147483648.0, v, 2147483647.0)));
+    case QTBDataValue::TYPE_UINT32: return QTBDataValue(quint32(qBound(0.0, v, 4294967295.0)));
+    case QTBDataValue::TYPE_FLOAT: break;
+    }
+    return QTBDataValue(float(v));
+}
+
+void LoadDataSource::flush()
+{
+    if(mRecordCount == 0)
+        return;
+    updateSamples(mRecords, mRecordCount);
+    mGenerated += mRecordCount;
+    mRecordCount = 0;
+}
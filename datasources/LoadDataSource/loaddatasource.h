@@ -0,0 +1,124 @@
+#ifndef LOADDATASOURCE_H
+#define LOADDATASOURCE_H
+
+#include <QtPlugin>
+#include <QThread>
+#include <QTimer>
+#include "data/data_source_interface.h"
+
+#define LOAD_SETTINGS_FILE "loaddatasource.ini"
+#define LOAD_DEFAULT_PERIOD_MS 10
+#define LOAD_BATCH_RECORDS 4096
+#define LOAD_MAX_PARAMETERS 1000000
+// samples queued per merge period, for the load is meant to exceed the default queue
+#define LOAD_QUEUE_CAPACITY (1 << 21)
+
+struct LoadGroup
+{
+    enum Waveform {
+        lwSine,
+        lwSquare,
+        lwTriangle,
+        lwSawtooth,
+        lwRandom
+    };
+
+    QString prefix;
+    int count;
+    double rate;                    // Hz, per parameter
+    QTBDataValue::ValueType type;
+    Waveform waveform;
+    double frequency;               // Hz of the waveform
+    float amplitude;
+    float offset;
+    double jitter;                  // fraction of the period
+    double burstPeriod;             // s, 0 without bursts
+    double burstLength;             // s
+    double burstFactor;             // rate multiplier during a burst
+    double outOfOrder;              // probability of a late sample
+    qint64 outOfOrderDelay;         // ns, latest delay of a late sample
+
+    // samples emitted since the start, sample s is for parameter s % count
+    quint64 emitted;
+    double position;                // samples due since the start
+    int firstSerie;                 // in mSerieIndexes
+};
+
+/* Synthetic load for capacity tests, driven by loaddatasource.ini next to
+ * the plugin:
+ *   Period         ms between two generation passes
+ *   Seed           of the random patterns
+ *   [Groups]       array of parameter groups:
+ *     Prefix         labels are <Prefix>_<index>
+ *     Count          parameters of the group
+ *     Rate           samples per second of each parameter
+ *     Type           int8, uint8, int16, uint16, int32, uint32, float
+ *     Waveform       sine, square, triangle, sawtooth, random
+ *     Frequency, Amplitude, Offset of the waveform
+ *     Jitter         timestamp noise, as a fraction of the period
+ *     BurstPeriod, BurstLength (s), BurstFactor: the rate is multiplied
+ *                    by BurstFactor during BurstLength every BurstPeriod
+ *     OutOfOrder     probability of a sample dated back by up to
+ *     OutOfOrderDelay  ms
+ * Parameters of a group are staggered over the period, a pass emits the
+ * samples due since the previous one in batches. Up to a million
+ * parameters, every sample goes through the queue of the source: the
+ * droppedSamples() count tells what the ingest could not take. Late
+ * samples (OutOfOrder, Jitter) are put back in order by their serie when
+ * they fall among its SERIE_REORDER_WINDOW newest samples, the others
+ * are counted by lateSamples(). A sample loaddatasource.ini is shipped
+ * with the sources. */
+class LoadDataSource: public DataSourceInterface
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID DataSourceInterface_iid FILE "loaddatasource.json")
+    Q_INTERFACES(DataSourceInterface)
+
+public:
+    LoadDataSource();
+    ~LoadDataSource() override;
+
+    bool startAcquisition() override;
+    bool stopAcquisition() override;
+
+    void loadSettings();
+    void registerParameters();
+    void unregisterParameters();
+
+public slots:
+    void updateData();
+
+protected:
+    void generate(LoadGroup &group, QTBTimestamp begin, QTBTimestamp end, double elapsedSec);
+    double burstFactor(const LoadGroup &group, double elapsedSec) const;
+    QTBDataValue value(const LoadGroup &group, int parameter, double timeSec);
+    void flush();
+
+    // xorshift64*, cheaper than QRandomGenerator per sample
+    quint64 random()
+    {
+        mRandom ^= mRandom >> 12;
+        mRandom ^= mRandom << 25;
+        mRandom ^= mRandom >> 27;
+        return mRandom * Q_UINT64_C(2685821657736338717);
+    }
+    double uniform() { return double(random() >> 11) * (1.0 / 9007199254740992.0); }
+
+    QThread *mThread;
+    QTimer *mTimer;
+
+    QVector<LoadGroup> mGroups;
+    QList<QSharedPointer<QTBParameter>> mListParam;
+    QVector<quint32> mSerieIndexes;
+
+    quint64 mSeed;
+    quint64 mRandom;
+    QTBTimestamp mStart;
+    QTBTimestamp mLast;
+    quint64 mGenerated;
+
+    QTBDataRecord mRecords[LOAD_BATCH_RECORDS];
+    quint32 mRecordCount;
+};
+
+#endif // LOADDATASOURCE_H
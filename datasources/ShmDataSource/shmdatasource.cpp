@@ -0,0 +1,156 @@
+#include "shmdatasource.h"
+#include <QSettings>
+
+ShmDataSource::ShmDataSource():
+    DataSourceInterface(SHM_QUEUE_CAPACITY)
+{
+    setAutoStart(true);
+    mThread = new QThread(this);
+    mTimer = new QTimer(nullptr); // _not_ this!
+    mTimer->setInterval(SHM_POLL_PERIOD_MS);
+    mTimer->setTimerType(Qt::PreciseTimer);
+    mTimer->moveToThread(mThread);
+    connect(mTimer, SIGNAL(timeout()), SLOT(updateData()), Qt::DirectConnection);
+    mTimer->connect(mThread, SIGNAL(started()), SLOT(start()));
+    mTimer->connect(mThread, SIGNAL(finished()), SLOT(stop()));
+}
+
+ShmDataSource::~ShmDataSource()
+{
+    mThread->quit();
+    mThread->wait();
+    mTimer->deleteLater();
+    mThread->deleteLater();
+    qDeleteAll(mSources);
+}
+
+bool ShmDataSource::startAcquisition()
+{
+    loadSettings();
+    if(mSources.isEmpty()) {
+        qWarning() << "ShmDataSource: no ring set in" << SHM_SETTINGS_FILE;
+        return false;
+    }
+
+    mThread->start();
+    return true;
+}
+
+bool ShmDataSource::stopAcquisition()
+{
+    mThread->quit();
+    mThread->wait();
+    unregisterParameters();
+
+    for(ShmRingSource *source : mSources) {
+        if(source->ring.isOpen())
+            qDebug() << "ShmDataSource:" << source->name << source->ring.dropped() << "samples dropped by the producer";
+        source->ring.close();
+    }
+    return true;
+}
+
+void ShmDataSource::loadSettings()
+{
+    QSettings settings(currentPath() + QDir::separator() + QString(SHM_SETTINGS_FILE), QSettings::IniFormat);
+
+    qDeleteAll(mSources);
+    mSources.clear();
+    for(const QString &name : settings.value(QString("Rings")).toStringList()) {
+        ShmRingSource *source = new ShmRingSource();
+        source->name = name.startsWith('/') ? name : QString("/") + name;
+        mSources.append(source);
+    }
+}
+
+void ShmDataSource::unregisterParameters()
+{
+    QVector<quint32> parameterIds;
+    for(ShmRingSource *source : mSources) {
+        for(const QSharedPointer<QTBParameter> &param : source->parameters)
+            parameterIds.append(param->parameterId());
+        source->parameters.clear();
+        source->serieIndexes.clear();
+        source->types.clear();
+    }
+    DataSource::unregisterParameters(parameterIds);
+}
+
+void ShmDataSource::updateData()
+{
+    for(ShmRingSource *source : mSources) {
+        // the producer may start after us
+        if(!source->ring.isOpen() && !source->ring.open(source->name.toLocal8Bit().constData()))
+            continue;
+
+        updateLabels(source);
+        drain(source);
+    }
+}
+
+void ShmDataSource::updateLabels(ShmRingSource *source)
+{
+    const quint32 count = qMin(source->ring.labelCount(), source->ring.header()->labelCapacity);
+    const quint32 first = quint32(source->serieIndexes.count());
+    if(first >= count)
+        return;
+
+    // the labels published since the last call are registered together
+    QList<QSharedPointer<QTBParameter>> params;
+    for(quint32 i = first; i < count; i++) {
+        const ShmRingLabel &entry = source->ring.labels()[i];
+        QSharedPointer<QTBParameter> param = QSharedPointer<QTBParameter>(new QTBParameter());
+        param->setLabel(QString::fromUtf8(entry.label, int(qstrnlen(entry.label, SHM_RING_LABEL_SIZE))));
+        param->setSourceName(QString("SHM") + source->name);
+        params.append(param);
+        source->types.append(entry.type <= QTBDataValue::TYPE_FLOAT ? QTBDataValue::ValueType(entry.type)
+                                                                   : QTBDataValue::TYPE_UINT32);
+    }
+    registerParameters(params);
+
+    // a label already taken by another source, or refused by the buffer, is not fed
+    for(const QSharedPointer<QTBParameter> &param : params) {
+        source->serieIndexes.append(param->parameterId());
+        if(param->parameterId())
+            source->parameters.append(param);
+    }
+}
+
+void ShmDataSource::drain(ShmRingSource *source)
+{
+    const quint32 labels = quint32(source->serieIndexes.count());
+    const quint32 labelCapacity = source->ring.header()->labelCapacity;
+    const quint32 *serieIndexes = source->serieIndexes.constData();
+    const QTBDataValue::ValueType *types = source->types.constData();
+
+    forever {
+        const quint32 count = source->ring.peek(mBatch, SHM_BATCH_RECORDS);
+        if(count == 0)
+            return;
+
+        // records of labels published after the table was read wait for the
+        // next call, those out of the table go to serie 0, ignored by the buffer
+        quint32 known = 0;
+        for(; known < count; known++) {
+            const ShmRingRecord &sample = mBatch[known];
+            QTBDataRecord &record = mRecords[known];
+            if(sample.label < labels) {
+                record.serieIndex = serieIndexes[sample.label];
+                record.value.mType = types[sample.label];
+            } else if(sample.label >= labelCapacity) {
+                record.serieIndex = 0;
+                record.value.mType = QTBDataValue::TYPE_UINT32;
+            } else {
+                break;
+            }
+            record.timestamp = sample.timestamp;
+            record.value.mValue.ui32 = sample.value;
+        }
+
+        // what the queue refuses stays in the ring, it is archived once taken
+        const quint32 accepted = known ? queueSamples(mRecords, known) : 0;
+        source->ring.release(accepted);
+        if(accepted < count)
+            return;
+    }
+}
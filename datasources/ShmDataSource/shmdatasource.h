@@ -0,0 +1,66 @@
+#ifndef SHMDATASOURCE_H
+#define SHMDATASOURCE_H
+
+#include <QtPlugin>
+#include <QThread>
+#include <QTimer>
+#include "data/data_source_interface.h"
+#include "shmring.h"
+
+#define SHM_SETTINGS_FILE "shmdatasource.ini"
+#define SHM_POLL_PERIOD_MS 1
+#define SHM_BATCH_RECORDS 4096
+// samples queued per merge period, for several rings drained every ms
+#define SHM_QUEUE_CAPACITY (1 << 20)
+
+struct ShmRingSource
+{
+    QString name;
+    ShmRingConsumer ring;
+    // serie index of each label of the ring, in the order of the table
+    QVector<quint32> serieIndexes;
+    QVector<QTBDataValue::ValueType> types;
+    QList<QSharedPointer<QTBParameter>> parameters;
+};
+
+/* Drains the shared memory rings of producers running on the same host,
+ * see shmring.h for the layout and the producer side. The settings are
+ * read from shmdatasource.ini next to the plugin:
+ *   Rings          names of the segments, one per producer
+ * A ring is attached once its producer created it, its labels are
+ * registered as they are published. Records are read by batches and only
+ * released once the sample queue took them, a busy queue leaves them in
+ * the ring. */
+class ShmDataSource: public DataSourceInterface
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID DataSourceInterface_iid FILE "shmdatasource.json")
+    Q_INTERFACES(DataSourceInterface)
+
+public:
+    ShmDataSource();
+    ~ShmDataSource() override;
+
+    bool startAcquisition() override;
+    bool stopAcquisition() override;
+
+    void loadSettings();
+    void unregisterParameters();
+
+public slots:
+    void updateData();
+
+protected:
+    void updateLabels(ShmRingSource *source);
+    void drain(ShmRingSource *source);
+
+    QThread *mThread;
+    QTimer *mTimer;
+
+    QList<ShmRingSource *> mSources;
+
+    ShmRingRecord mBatch[SHM_BATCH_RECORDS];
+    QTBDataRecord mRecords[SHM_BATCH_RECORDS];
+};
+
+#endif // SHMDATASOURCE_H
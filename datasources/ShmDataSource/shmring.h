@@ -0,0 +1,271 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+/* Shared memory ring between one producer process and CuteBoard, on the
+ * same host. Plain C++11 and POSIX, producers need neither Qt nor
+ * CuteBoard to include it.
+ *
+ * Layout of the segment /<name>, native byte order:
+ *   ShmRingHeader                      one cache line per moving index
+ *   ShmRingLabel[labelCapacity]        parameters, in publication order
+ *   ShmRingRecord[capacity]            samples, capacity a power of two
+ *
+ * The producer writes the records then publishes them by moving head
+ * (release); CuteBoard reads up to head (acquire) and gives the slots back
+ * by moving tail. A label is published the same way by labelCount, and
+ * the header by magic, written last. A full ring rejects the sample and
+ * counts it in dropped. Publishing makes no system call.
+ *
+ * Producer side:
+ *   ShmRingProducer ring;
+ *   ring.open("cuteboard_acq");
+ *   int temperature = ring.addLabel("TEMPERATURE", SHM_RING_TYPE_FLOAT);
+ *   ring.publish(temperature, timestampNs, 21.5f);
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define SHM_RING_MAGIC 0x52425451 // "QTBR"
+#define SHM_RING_VERSION 1
+#define SHM_RING_LABEL_SIZE 60
+#define SHM_RING_DEFAULT_CAPACITY 65536
+#define SHM_RING_DEFAULT_LABELS 4096
+
+// same values as QTBDataValue::ValueType
+enum ShmRingType {
+    SHM_RING_TYPE_INT8,
+    SHM_RING_TYPE_UINT8,
+    SHM_RING_TYPE_INT16,
+    SHM_RING_TYPE_UINT16,
+    SHM_RING_TYPE_INT32,
+    SHM_RING_TYPE_UINT32,
+    SHM_RING_TYPE_FLOAT
+};
+
+struct ShmRingHeader
+{
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t labelCapacity;
+    std::atomic<uint64_t> dropped;
+    alignas(64) std::atomic<uint64_t> head;         // producer
+    alignas(64) std::atomic<uint64_t> tail;         // CuteBoard
+    alignas(64) std::atomic<uint32_t> labelCount;   // producer
+};
+
+struct ShmRingLabel
+{
+    char label[SHM_RING_LABEL_SIZE];    // null terminated
+    uint32_t type;                      // ShmRingType
+};
+
+struct ShmRingRecord
+{
+    int64_t timestamp;  // ns since epoch
+    uint32_t label;     // index in the label table
+    uint32_t value;     // as stored in QTBDataValue, small types in the low bytes
+};
+
+static_assert(sizeof(ShmRingLabel) == 64, "one label per cache line");
+static_assert(sizeof(ShmRingRecord) == 16, "packed records");
+
+class ShmRing
+{
+public:
+    static size_t segmentSize(uint32_t capacity, uint32_t labelCapacity)
+    {
+        return sizeof(ShmRingHeader) + labelCapacity * sizeof(ShmRingLabel) + capacity * sizeof(ShmRingRecord);
+    }
+
+    ShmRing() :
+        mHeader(nullptr),
+        mSize(0) {}
+
+    ~ShmRing() { close(); }
+
+    ShmRing(const ShmRing &) = delete;
+    ShmRing &operator=(const ShmRing &) = delete;
+
+    bool isOpen() const { return mHeader != nullptr; }
+
+    void close()
+    {
+        if(mHeader)
+            munmap(mHeader, mSize);
+        mHeader = nullptr;
+        mSize = 0;
+    }
+
+    ShmRingHeader *header() const { return mHeader; }
+    ShmRingLabel *labels() const { return reinterpret_cast<ShmRingLabel*>(mHeader + 1); }
+    ShmRingRecord *records() const { return reinterpret_cast<ShmRingRecord*>(labels() + mHeader->labelCapacity); }
+
+protected:
+    // maps the segment, create sizes and initializes it when needed
+    bool map(const char *name, bool create, uint32_t capacity, uint32_t labelCapacity)
+    {
+        close();
+        const int fd = shm_open(name, create ? O_RDWR | O_CREAT : O_RDWR, 0660);
+        if(fd < 0)
+            return false;
+
+        struct stat status;
+        if(fstat(fd, &status) < 0 || (!create && size_t(status.st_size) < sizeof(ShmRingHeader))) {
+            ::close(fd);
+            return false;
+        }
+
+        size_t size = size_t(status.st_size);
+        const bool initialize = create && size == 0;
+        if(initialize) {
+            size = segmentSize(capacity, labelCapacity);
+            if(ftruncate(fd, off_t(size)) < 0) {
+                ::close(fd);
+                return false;
+            }
+        }
+
+        void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(address == MAP_FAILED)
+            return false;
+        mHeader = static_cast<ShmRingHeader*>(address);
+        mSize = size;
+
+        if(initialize) {
+            mHeader->version = SHM_RING_VERSION;
+            mHeader->capacity = capacity;
+            mHeader->labelCapacity = labelCapacity;
+            mHeader->dropped.store(0, std::memory_order_relaxed);
+            mHeader->head.store(0, std::memory_order_relaxed);
+            mHeader->tail.store(0, std::memory_order_relaxed);
+            mHeader->labelCount.store(0, std::memory_order_relaxed);
+            mHeader->magic.store(SHM_RING_MAGIC, std::memory_order_release);
+        }
+
+        // a segment being initialized by its producer is tried again later
+        if(mHeader->magic.load(std::memory_order_acquire) != SHM_RING_MAGIC
+                || mHeader->version != SHM_RING_VERSION
+                || (mHeader->capacity & (mHeader->capacity - 1)) != 0
+                || segmentSize(mHeader->capacity, mHeader->labelCapacity) > mSize) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    ShmRingHeader *mHeader;
+    size_t mSize;
+};
+
+class ShmRingProducer : public ShmRing
+{
+public:
+    // a segment left by a previous run is attached as it is, its labels kept;
+    // capacity must be a power of two
+    bool open(const char *name,
+              uint32_t capacity = SHM_RING_DEFAULT_CAPACITY,
+              uint32_t labelCapacity = SHM_RING_DEFAULT_LABELS)
+    {
+        return map(name, true, capacity, labelCapacity);
+    }
+
+    // index of the label, published when first seen; -1 when the table is full
+    int addLabel(const char *label, ShmRingType type)
+    {
+        const uint32_t count = mHeader->labelCount.load(std::memory_order_relaxed);
+        for(uint32_t i = 0; i < count; i++) {
+            if(strncmp(labels()[i].label, label, SHM_RING_LABEL_SIZE - 1) == 0)
+                return int(i);
+        }
+        if(count == mHeader->labelCapacity)
+            return -1;
+
+        ShmRingLabel &entry = labels()[count];
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.label, label, SHM_RING_LABEL_SIZE - 1);
+        entry.type = uint32_t(type);
+        mHeader->labelCount.store(count + 1, std::memory_order_release);
+        return int(count);
+    }
+
+    bool publish(uint32_t label, int64_t timestamp, float value) { return publish(label, timestamp, &value, sizeof(value)); }
+    bool publish(uint32_t label, int64_t timestamp, int32_t value) { return publish(label, timestamp, &value, sizeof(value)); }
+    bool publish(uint32_t label, int64_t timestamp, uint32_t value) { return publish(label, timestamp, &value, sizeof(value)); }
+    bool publish(uint32_t label, int64_t timestamp, int16_t value) { return publish(label, timestamp, &value, sizeof(value)); }
+    bool publish(uint32_t label, int64_t timestamp, uint16_t value) { return publish(label, timestamp, &value, sizeof(value)); }
+    bool publish(uint32_t label, int64_t timestamp, int8_t value) { return publish(label, timestamp, &value, sizeof(value)); }
+    bool publish(uint32_t label, int64_t timestamp, uint8_t value) { return publish(label, timestamp, &value, sizeof(value)); }
+
+    // several samples with one publication, returns how many fit
+    uint32_t publish(const ShmRingRecord *samples, uint32_t count)
+    {
+        const uint64_t head = mHeader->head.load(std::memory_order_relaxed);
+        const uint64_t free = mHeader->capacity - (head - mHeader->tail.load(std::memory_order_acquire));
+        const uint32_t accepted = free < count ? uint32_t(free) : count;
+        const uint64_t mask = mHeader->capacity - 1;
+        for(uint32_t i = 0; i < accepted; i++)
+            records()[(head + i) & mask] = samples[i];
+        mHeader->head.store(head + accepted, std::memory_order_release);
+        if(accepted < count)
+            mHeader->dropped.fetch_add(count - accepted, std::memory_order_relaxed);
+        return accepted;
+    }
+
+private:
+    bool publish(uint32_t label, int64_t timestamp, const void *value, size_t size)
+    {
+        const uint64_t head = mHeader->head.load(std::memory_order_relaxed);
+        if(head - mHeader->tail.load(std::memory_order_acquire) >= mHeader->capacity) {
+            mHeader->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        ShmRingRecord &record = records()[head & (mHeader->capacity - 1)];
+        record.timestamp = timestamp;
+        record.label = label;
+        record.value = 0;
+        memcpy(&record.value, value, size);
+        mHeader->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+class ShmRingConsumer : public ShmRing
+{
+public:
+    // the producer creates the segment, false until it did
+    bool open(const char *name) { return map(name, false, 0, 0); }
+
+    // copies up to max published records, they stay in the ring until released
+    uint32_t peek(ShmRingRecord *samples, uint32_t max) const
+    {
+        const uint64_t tail = mHeader->tail.load(std::memory_order_relaxed);
+        uint64_t available = mHeader->head.load(std::memory_order_acquire) - tail;
+        if(available > max)
+            available = max;
+
+        const uint64_t mask = mHeader->capacity - 1;
+        for(uint64_t i = 0; i < available; i++)
+            samples[i] = records()[(tail + i) & mask];
+        return uint32_t(available);
+    }
+
+    // gives the count oldest records back to the producer
+    void release(uint32_t count)
+    {
+        mHeader->tail.fetch_add(count, std::memory_order_release);
+    }
+
+    uint32_t labelCount() const { return mHeader->labelCount.load(std::memory_order_acquire); }
+    uint64_t dropped() const { return mHeader->dropped.load(std::memory_order_relaxed); }
+};
+
+#endif // SHMRING_H
@@ -0,0 +1,429 @@
+#include "tcpdatasource.h"
+#include <QSettings>
+#include <QFileInfo>
+#include <QtEndian>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+TcpDataSource::TcpDataSource():
+    DataSourceInterface(TCP_QUEUE_CAPACITY),
+    mTextPort(0),
+    mBinaryPort(0),
+    mTimeScale(TIMESTAMP_NS_PER_SEC),
+    mMaxConnections(4096),
+    mMaxLabels(TCP_DEFAULT_MAX_LABELS),
+    mEpollFd(-1),
+    mTextFd(-1),
+    mBinaryFd(-1),
+    mReceiveTime(0),
+    mSampleCount(0),
+    mMalformedCount(0),
+    mRejectedLabels(0)
+{
+    setAutoStart(true);
+    mThread = new QThread(this);
+    mTimer = new QTimer(nullptr); // _not_ this!
+    mTimer->setInterval(TCP_POLL_PERIOD_MS);
+    mTimer->setTimerType(Qt::PreciseTimer);
+    mTimer->moveToThread(mThread);
+    connect(mTimer, SIGNAL(timeout()), SLOT(updateData()), Qt::DirectConnection);
+    mTimer->connect(mThread, SIGNAL(started()), SLOT(start()));
+    mTimer->connect(mThread, SIGNAL(finished()), SLOT(stop()));
+}
+
+TcpDataSource::~TcpDataSource()
+{
+    mThread->quit();
+    mThread->wait();
+    mTimer->deleteLater();
+    mThread->deleteLater();
+    closeAll();
+}
+
+bool TcpDataSource::startAcquisition()
+{
+    loadSettings();
+
+    mEpollFd = epoll_create1(0);
+    if(mEpollFd < 0) {
+        qWarning() << "TcpDataSource: epoll" << strerror(errno);
+        return false;
+    }
+    if(mTextPort)
+        mTextFd = listen(mTextPort);
+    if(mBinaryPort)
+        mBinaryFd = listen(mBinaryPort);
+    if(mTextFd < 0 && mBinaryFd < 0) {
+        closeAll();
+        return false;
+    }
+
+    mSampleCount = 0;
+    mMalformedCount = 0;
+    mRejectedLabels = 0;
+    mThread->start();
+    return true;
+}
+
+bool TcpDataSource::stopAcquisition()
+{
+    mThread->quit();
+    mThread->wait();
+    qDebug() << "TcpDataSource:" << mSampleCount << "samples," << mMalformedCount << "malformed,"
+             << mRejectedLabels << "labels over the limit";
+    closeAll();
+    unregisterParameters();
+    return true;
+}
+
+void TcpDataSource::loadSettings()
+{
+    const QString fileName = currentPath() + QDir::separator() + QString(TCP_SETTINGS_FILE);
+    QSettings settings(fileName, QSettings::IniFormat);
+
+    // ports are opened on purpose only, a missing ini serves none
+    if(!QFileInfo(fileName).exists())
+        qWarning() << "TcpDataSource: no" << fileName << "nothing is served";
+    mAddress = settings.value(QString("Address"), QString("127.0.0.1")).toString();
+    mTextPort = quint16(settings.value(QString("TextPort"), 0).toUInt());
+    mBinaryPort = quint16(settings.value(QString("BinaryPort"), 0).toUInt());
+    mMaxConnections = settings.value(QString("MaxConnections"), 4096).toInt();
+    mMaxLabels = settings.value(QString("MaxLabels"), TCP_DEFAULT_MAX_LABELS).toInt();
+    mSourceName = settings.value(QString("SourceName"), QString("TCP")).toString();
+
+    QString unit = settings.value(QString("TimeUnit"), QString("s")).toString();
+    if(unit == QString("ms"))
+        mTimeScale = TIMESTAMP_NS_PER_MSEC;
+    else if(unit == QString("us"))
+        mTimeScale = 1000;
+    else if(unit == QString("ns"))
+        mTimeScale = 1;
+    else
+        mTimeScale = TIMESTAMP_NS_PER_SEC;
+}
+
+int TcpDataSource::listen(quint16 port)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(fd < 0) {
+        qWarning() << "TcpDataSource: socket" << strerror(errno);
+        return -1;
+    }
+
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if(inet_pton(AF_INET, mAddress.toLatin1().constData(), &address.sin_addr) != 1
+            || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+            || ::listen(fd, SOMAXCONN) < 0) {
+        qWarning() << "TcpDataSource: listen" << mAddress << port << strerror(errno);
+        ::close(fd);
+        return -1;
+    }
+
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &event);
+    return fd;
+}
+
+void TcpDataSource::closeAll()
+{
+    for(TcpConnection *connection : mConnections) {
+        ::close(connection->fd);
+        delete connection;
+    }
+    mConnections.clear();
+
+    if(mTextFd >= 0)
+        ::close(mTextFd);
+    if(mBinaryFd >= 0)
+        ::close(mBinaryFd);
+    if(mEpollFd >= 0)
+        ::close(mEpollFd);
+    mTextFd = mBinaryFd = mEpollFd = -1;
+}
+
+void TcpDataSource::unregisterParameters()
+{
+    QVector<quint32> parameterIds;
+    parameterIds.reserve(mListParam.count());
+    for(const QSharedPointer<QTBParameter> &param : mListParam)
+        parameterIds.append(param->parameterId());
+    DataSource::unregisterParameters(parameterIds);
+    mListParam.clear();
+    mSerieIndexes.clear();
+}
+
+void TcpDataSource::updateData()
+{
+    epoll_event events[TCP_EPOLL_EVENTS];
+
+    // the ready sockets are served until none is left, without waiting
+    int count;
+    do {
+        count = epoll_wait(mEpollFd, events, TCP_EPOLL_EVENTS, 0);
+        mReceiveTime = timestampNow();
+        for(int i = 0; i < count; i++) {
+            const int fd = events[i].data.fd;
+            if(fd == mTextFd || fd == mBinaryFd) {
+                accept(fd, fd == mBinaryFd);
+                continue;
+            }
+
+            TcpConnection *connection = mConnections.value(fd, nullptr);
+            if(!connection)
+                continue;
+            if(events[i].events & EPOLLIN)
+                receive(connection);
+            else if(events[i].events & (EPOLLHUP | EPOLLERR))
+                close(connection);
+        }
+    } while(count == TCP_EPOLL_EVENTS);
+}
+
+void TcpDataSource::accept(int listenFd, bool binary)
+{
+    forever {
+        const int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0)
+            return;
+
+        if(mConnections.count() >= mMaxConnections) {
+            ::close(fd);
+            continue;
+        }
+
+        TcpConnection *connection = new TcpConnection();
+        connection->fd = fd;
+        connection->binary = binary;
+        mConnections.insert(fd, connection);
+
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+void TcpDataSource::close(TcpConnection *connection)
+{
+    // closing the descriptor removes it from the epoll set
+    mConnections.remove(connection->fd);
+    ::close(connection->fd);
+    delete connection;
+}
+
+void TcpDataSource::receive(TcpConnection *connection)
+{
+    // a bounded number of reads per event, the other connections get their turn
+    for(int read = 0; read < TCP_READS_PER_EVENT; read++) {
+        QByteArray &pending = connection->pending;
+        const int size = pending.size();
+        pending.resize(size + TCP_READ_SIZE);
+        const ssize_t received = ::recv(connection->fd, pending.data() + size, TCP_READ_SIZE, 0);
+        if(received <= 0) {
+            pending.resize(size);
+            if(received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+                close(connection);
+            return;
+        }
+        pending.resize(size + int(received));
+
+        mRecords.resize(0);
+        const int parsed = connection->binary ? parseMessages(pending.constData(), pending.size())
+                                              : parseLines(pending.data(), pending.size());
+        // the labels first seen in the read are settled, even when it is dropped
+        registerNewLabels();
+        if(parsed < 0) {
+            mMalformedCount++;
+            close(connection);
+            return;
+        }
+        pending.remove(0, parsed);
+
+        if(!mRecords.isEmpty()) {
+            updateSamples(mRecords);
+            mSampleCount += quint64(mRecords.size());
+        }
+
+        if(received < TCP_READ_SIZE)
+            return;
+    }
+}
+
+int TcpDataSource::parseLines(char *data, int size)
+{
+    int parsed = 0;
+    forever {
+        char *line = data + parsed;
+        char *end = static_cast<char*>(memchr(line, '\n', size_t(size - parsed)));
+        if(!end)
+            return size - parsed > TCP_MAX_LINE ? -1 : parsed;
+        parsed = int(end - data) + 1;
+
+        // the line is cut in place, the buffer is ours
+        *end = '\0';
+        if(end > line && end[-1] == '\r')
+            *--end = '\0';
+
+        char *label = line;
+        while(*label == ' ' || *label == '\t')
+            label++;
+        char *labelEnd = label;
+        while(*labelEnd && *labelEnd != ' ' && *labelEnd != '\t')
+            labelEnd++;
+        if(labelEnd == label)
+            continue;
+
+        char *field = labelEnd;
+        char *valueEnd;
+        // every text value is a float, "20" then "20.5" keeps the type of the serie
+        const QTBDataValue value(strtof(field, &valueEnd));
+        if(valueEnd == field) {
+            mMalformedCount++;
+            continue;
+        }
+
+        while(*valueEnd == ' ' || *valueEnd == '\t')
+            valueEnd++;
+
+        QTBDataRecord record;
+        record.serieIndex = serieIndex(label, int(labelEnd - label));
+        record.timestamp = *valueEnd ? parseTimestamp(valueEnd) : mReceiveTime;
+        record.value = value;
+        mRecords.append(record);
+    }
+}
+
+int TcpDataSource::parseMessages(const char *data, int size)
+{
+    int parsed = 0;
+    while(size - parsed >= TCP_BINARY_HEADER_SIZE) {
+        const uchar *message = reinterpret_cast<const uchar*>(data + parsed);
+        const quint32 messageSize = qFromLittleEndian<quint32>(message);
+        const int labelSize = message[13];
+        if(labelSize == 0 || int(messageSize) != TCP_BINARY_HEADER_SIZE - 4 + labelSize + 4 || message[12] > QTBDataValue::TYPE_FLOAT)
+            return -1;
+        if(size - parsed < int(messageSize) + 4)
+            break;
+
+        // the 4 value bytes are stored as they are, the type tells how to read them
+        QTBDataValue value;
+        const quint32 raw = qFromLittleEndian<quint32>(message + TCP_BINARY_HEADER_SIZE + labelSize);
+        switch(QTBDataValue::ValueType(message[12])) {
+        case QTBDataValue::TYPE_INT8: value = QTBDataValue(qint8(raw)); break;
+        case QTBDataValue::TYPE_UINT8: value = QTBDataValue(quint8(raw)); break;
+        case QTBDataValue::TYPE_INT16: value = QTBDataValue(qint16(raw)); break;
+        case QTBDataValue::TYPE_UINT16: value = QTBDataValue(quint16(raw)); break;
+        case QTBDataValue::TYPE_INT32: value = QTBDataValue(qint32(raw)); break;
+        case QTBDataValue::TYPE_UINT32: value = QTBDataValue(raw); break;
+        case QTBDataValue::TYPE_FLOAT: {
+            float real;
+            memcpy(&real, &raw, sizeof(real));
+            value = QTBDataValue(real);
+            break;
+        }
+        }
+
+        QTBDataRecord record;
+        record.serieIndex = serieIndex(reinterpret_cast<const char*>(message) + TCP_BINARY_HEADER_SIZE, labelSize);
+        record.timestamp = qFromLittleEndian<qint64>(message + 4);
+        record.value = value;
+        mRecords.append(record);
+
+        parsed += int(messageSize) + 4;
+    }
+    return parsed;
+}
+
+quint32 TcpDataSource::serieIndex(const char *label, int size)
+{
+    // no copy of the label once it is known
+    const QByteArray key = QByteArray::fromRawData(label, size);
+    QHash<QByteArray, quint32>::const_iterator known = mSerieIndexes.constFind(key);
+    if(known != mSerieIndexes.constEnd())
+        return known.value();
+
+    // new labels are registered together at the end of the read, see registerNewLabels()
+    QHash<QByteArray, int>::const_iterator newLabel = mNewLabels.constFind(key);
+    int position;
+    if(newLabel != mNewLabels.constEnd()) {
+        position = newLabel.value();
+    } else {
+        // producers don't get to grow the tables without bound
+        if(mSerieIndexes.count() + mNewLabels.count() >= mMaxLabels) {
+            mRejectedLabels++;
+            return 0;
+        }
+        QSharedPointer<QTBParameter> param = QSharedPointer<QTBParameter>(new QTBParameter());
+        param->setLabel(QString::fromUtf8(label, size));
+        param->setSourceName(mSourceName);
+        position = mNewParams.count();
+        mNewParams.append(param);
+        mNewLabels.insert(QByteArray(label, size), position);
+    }
+    // the record is appended next
+    mNewRecords.append(qMakePair(mRecords.count(), position));
+    return 0;
+}
+
+void TcpDataSource::registerNewLabels()
+{
+    if(mNewParams.isEmpty())
+        return;
+
+    registerParameters(mNewParams);
+
+    // a label already taken by another source, or refused by the buffer, is not fed
+    QHash<QByteArray, int>::const_iterator it;
+    for(it = mNewLabels.constBegin(); it != mNewLabels.constEnd(); ++it) {
+        const QSharedPointer<QTBParameter> &param = mNewParams.at(it.value());
+        mSerieIndexes.insert(it.key(), param->parameterId());
+        if(param->parameterId())
+            mListParam.append(param);
+    }
+    for(const QPair<int, int> &record : mNewRecords)
+        mRecords[record.first].serieIndex = mNewParams.at(record.second)->parameterId();
+
+    mNewLabels.clear();
+    mNewParams.clear();
+    mNewRecords.clear();
+}
+
+QTBTimestamp TcpDataSource::parseTimestamp(const char *field) const
+{
+    // integer and decimal parts apart, a double would round epoch nanoseconds
+    bool negative = false;
+    if(*field == '-' || *field == '+')
+        negative = *field++ == '-';
+
+    qint64 integer = 0;
+    while(*field >= '0' && *field <= '9')
+        integer = integer * 10 + (*field++ - '0');
+
+    qint64 fraction = 0;
+    if(*field == '.') {
+        field++;
+        qint64 digitScale = mTimeScale;
+        while(*field >= '0' && *field <= '9') {
+            digitScale /= 10;
+            fraction += (*field++ - '0') * digitScale;
+        }
+    }
+
+    const QTBTimestamp timestamp = integer * mTimeScale + fraction;
+    return negative ? -timestamp : timestamp;
+}
@@ -0,0 +1,115 @@
+#ifndef TCPDATASOURCE_H
+#define TCPDATASOURCE_H
+
+#include <QtPlugin>
+#include <QThread>
+#include <QTimer>
+#include <QHash>
+#include "data/data_source_interface.h"
+
+#define TCP_SETTINGS_FILE "tcpdatasource.ini"
+#define TCP_POLL_PERIOD_MS 1
+#define TCP_EPOLL_EVENTS 256
+#define TCP_READ_SIZE 65536
+#define TCP_READS_PER_EVENT 4
+#define TCP_MAX_LINE 4096
+#define TCP_BINARY_HEADER_SIZE 16
+#define TCP_DEFAULT_MAX_LABELS 65536
+// samples queued per merge period, for thousands of clients
+#define TCP_QUEUE_CAPACITY (1 << 20)
+
+struct TcpConnection
+{
+    TcpConnection() :
+        fd(-1),
+        binary(false) {}
+
+    int fd;
+    bool binary;
+    // received bytes not parsed yet, an incomplete message
+    QByteArray pending;
+};
+
+/* Serves TCP producers on one thread, all connections multiplexed on a
+ * single epoll set. The settings are read from tcpdatasource.ini next to
+ * the plugin, nothing is served without it:
+ *   Address        listening address, 127.0.0.1 by default
+ *   TextPort       port of the line protocol, one sample per line:
+ *                  "label value [timestamp]", values are floats, the
+ *                  receive time when the timestamp is missing
+ *   BinaryPort     port of the binary protocol, little endian messages:
+ *                  quint32 size of the rest, qint64 timestamp in ns,
+ *                  quint8 value type (QTBDataValue::ValueType),
+ *                  quint8 label size, quint16 reserved,
+ *                  the label (1 to 255 bytes) then 4 bytes of value
+ *   TimeUnit       line protocol timestamps, s (default), ms, us or ns
+ *   MaxConnections beyond it new connections are closed
+ *   MaxLabels      beyond it new labels are neither registered nor fed
+ *   SourceName     source name of the parameters, TCP by default
+ * A port left out is not served. Parameters are registered when their
+ * label is first received, the new labels of a read together. Samples of
+ * one read are pushed to the queue in a single batch. Linux only. */
+class TcpDataSource: public DataSourceInterface
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID DataSourceInterface_iid FILE "tcpdatasource.json")
+    Q_INTERFACES(DataSourceInterface)
+
+public:
+    TcpDataSource();
+    ~TcpDataSource() override;
+
+    bool startAcquisition() override;
+    bool stopAcquisition() override;
+
+    void loadSettings();
+    void unregisterParameters();
+
+public slots:
+    void updateData();
+
+protected:
+    int listen(quint16 port);
+    void accept(int listenFd, bool binary);
+    void receive(TcpConnection *connection);
+    void close(TcpConnection *connection);
+    void closeAll();
+    int parseLines(char *data, int size);
+    int parseMessages(const char *data, int size);
+    quint32 serieIndex(const char *label, int size);
+    void registerNewLabels();
+    QTBTimestamp parseTimestamp(const char *field) const;
+
+    QThread *mThread;
+    QTimer *mTimer;
+
+    QString mAddress;
+    quint16 mTextPort;
+    quint16 mBinaryPort;
+    qint64 mTimeScale;
+    int mMaxConnections;
+    int mMaxLabels;
+    QString mSourceName;
+
+    int mEpollFd;
+    int mTextFd;
+    int mBinaryFd;
+    QHash<int, TcpConnection *> mConnections;
+
+    // labels seen so far, registered on the first sample
+    QHash<QByteArray, quint32> mSerieIndexes;
+    QList<QSharedPointer<QTBParameter>> mListParam;
+    // labels first seen in the current read, by position in mNewParams, and the records
+    // waiting for their serie index as (record, new parameter) positions
+    QHash<QByteArray, int> mNewLabels;
+    QList<QSharedPointer<QTBParameter>> mNewParams;
+    QVector<QPair<int, int>> mNewRecords;
+
+    QVector<QTBDataRecord> mRecords;
+    QTBTimestamp mReceiveTime;
+    quint64 mSampleCount;
+    quint64 mMalformedCount;
+    quint64 mRejectedLabels;
+};
+
+#endif // TCPDATASOURCE_H
@@ -0,0 +1,324 @@
+#include "udpdatasource.h"
+#include <QSettings>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+UdpDataSource::UdpDataSource():
+    DataSourceInterface(UDP_QUEUE_CAPACITY),
+    mReceiveBuffer(UDP_DEFAULT_RECEIVE_BUFFER)
+{
+    setAutoStart(true);
+    mThread = new QThread(this);
+    mTimer = new QTimer(nullptr); // _not_ this!
+    mTimer->setInterval(UDP_POLL_PERIOD_MS);
+    mTimer->setTimerType(Qt::PreciseTimer);
+    mTimer->moveToThread(mThread);
+    connect(mTimer, SIGNAL(timeout()), SLOT(updateData()), Qt::DirectConnection);
+    mTimer->connect(mThread, SIGNAL(started()), SLOT(start()));
+    mTimer->connect(mThread, SIGNAL(finished()), SLOT(stop()));
+
+    mFrames.resize(UDP_BATCH_FRAMES * UDP_FRAME_MAX_SIZE);
+    mControls.resize(UDP_BATCH_FRAMES * UDP_CONTROL_SIZE);
+}
+
+UdpDataSource::~UdpDataSource()
+{
+    mThread->quit();
+    mThread->wait();
+    mTimer->deleteLater();
+    mThread->deleteLater();
+    closeSockets();
+    qDeleteAll(mSockets);
+}
+
+bool UdpDataSource::startAcquisition()
+{
+    loadSettings();
+    if(!openSockets())
+        return false;
+
+    registerParameters();
+    mThread->start();
+    return true;
+}
+
+bool UdpDataSource::stopAcquisition()
+{
+    mThread->quit();
+    mThread->wait();
+    unregisterParameters();
+
+    for(UdpSocket *socket : mSockets) {
+        qDebug() << "UdpDataSource:" << socket->group << socket->port
+                 << socket->frames.loadAcquire() << "frames,"
+                 << socket->shortFrames.loadAcquire() << "short,"
+                 << socket->kernelDrops.loadAcquire() << "dropped by the socket,"
+                 << socket->queueDrops.loadAcquire() << "samples dropped by the queue";
+    }
+    closeSockets();
+    return true;
+}
+
+void UdpDataSource::loadSettings()
+{
+    QSettings settings(currentPath() + QDir::separator() + QString(UDP_SETTINGS_FILE), QSettings::IniFormat);
+
+    mReceiveBuffer = settings.value(QString("ReceiveBuffer"), UDP_DEFAULT_RECEIVE_BUFFER).toInt();
+
+    closeSockets();
+    qDeleteAll(mSockets);
+    mSockets.clear();
+    mLayouts.clear();
+    mListParam.clear();
+
+    QHash<QString, int> layoutIndexes;
+    const int socketCount = settings.beginReadArray(QString("Sockets"));
+    for(int i = 0; i < socketCount; i++) {
+        settings.setArrayIndex(i);
+        UdpSocket *socket = new UdpSocket();
+        socket->group = settings.value(QString("Group"), QString("127.0.0.1")).toString();
+        socket->interfaceAddress = settings.value(QString("Interface")).toString();
+        socket->port = quint16(settings.value(QString("Port")).toUInt());
+        const QString layout = settings.value(QString("Layout")).toString();
+        socket->layout = layoutIndexes.value(layout, -1);
+        if(socket->layout < 0) {
+            socket->layout = mLayouts.count();
+            layoutIndexes.insert(layout, socket->layout);
+            UdpFrameLayout frameLayout;
+            frameLayout.name = layout;
+            mLayouts.append(frameLayout);
+        }
+        mSockets.append(socket);
+    }
+    settings.endArray();
+
+    // the layouts are read once, whatever the number of sockets sharing them
+    for(UdpFrameLayout &layout : mLayouts) {
+        settings.beginGroup(layout.name);
+        layout.bigEndian = settings.value(QString("BigEndian"), true).toBool();
+
+        const QString unit = settings.value(QString("TimeUnit"), QString("ns")).toString();
+        qint64 scale = 1;
+        if(unit == QString("s"))
+            scale = TIMESTAMP_NS_PER_SEC;
+        else if(unit == QString("ms"))
+            scale = TIMESTAMP_NS_PER_MSEC;
+        else if(unit == QString("us"))
+            scale = 1000;
+        layout.setTimeOffset(settings.value(QString("TimeOffset"), -1).toInt(), scale);
+
+        const int fieldCount = settings.beginReadArray(QString("Fields"));
+        for(int i = 0; i < fieldCount; i++) {
+            settings.setArrayIndex(i);
+            const QString label = settings.value(QString("Label")).toString();
+            const QTBDataValue::ValueType type = UdpFrameLayout::valueType(settings.value(QString("Type")).toString());
+            layout.addField(label, settings.value(QString("Offset")).toUInt(), type);
+
+            QSharedPointer<QTBParameter> param = QSharedPointer<QTBParameter>(new QTBParameter());
+            param->setLabel(label);
+            param->setSourceName(QString("UDP/") + layout.name);
+            mListParam.append(param);
+        }
+        settings.endArray();
+        settings.endGroup();
+
+        mValues.resize(qMax(mValues.size(), layout.fields.size()));
+    }
+}
+
+bool UdpDataSource::openSockets()
+{
+    if(mSockets.isEmpty()) {
+        qWarning() << "UdpDataSource: no socket set in" << UDP_SETTINGS_FILE;
+        return false;
+    }
+
+    for(UdpSocket *socket : mSockets) {
+        if(!openSocket(socket)) {
+            closeSockets();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UdpDataSource::openSocket(UdpSocket *socket)
+{
+    in_addr group;
+    if(inet_pton(AF_INET, socket->group.toLatin1().constData(), &group) != 1) {
+        qWarning() << "UdpDataSource: invalid address" << socket->group;
+        return false;
+    }
+    const bool multicast = IN_MULTICAST(ntohl(group.s_addr));
+
+    socket->fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if(socket->fd < 0) {
+        qWarning() << "UdpDataSource: socket" << strerror(errno);
+        return false;
+    }
+    fcntl(socket->fd, F_SETFL, fcntl(socket->fd, F_GETFL) | O_NONBLOCK);
+
+    int enable = 1;
+    setsockopt(socket->fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    setsockopt(socket->fd, SOL_SOCKET, SO_RCVBUF, &mReceiveBuffer, sizeof(mReceiveBuffer));
+#ifdef Q_OS_LINUX
+    // kernel drop counter and receive time of each frame, as ancillary data
+    setsockopt(socket->fd, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+    setsockopt(socket->fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+#endif
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(socket->port);
+    address.sin_addr = group;
+    if(bind(socket->fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        qWarning() << "UdpDataSource: bind" << socket->group << socket->port << strerror(errno);
+        return false;
+    }
+
+    if(multicast) {
+        ip_mreq membership;
+        membership.imr_multiaddr = group;
+        membership.imr_interface.s_addr = htonl(INADDR_ANY);
+        if(!socket->interfaceAddress.isEmpty())
+            inet_pton(AF_INET, socket->interfaceAddress.toLatin1().constData(), &membership.imr_interface);
+        if(setsockopt(socket->fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+            qWarning() << "UdpDataSource: join" << socket->group << strerror(errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+void UdpDataSource::closeSockets()
+{
+    for(UdpSocket *socket : mSockets) {
+        if(socket->fd >= 0) {
+            ::close(socket->fd);
+            socket->fd = -1;
+        }
+    }
+}
+
+void UdpDataSource::registerParameters()
+{
+    if(DataSource::registerParameters(mListParam) < mListParam.count()) {
+        for(const QSharedPointer<QTBParameter> &param : mListParam)
+            if(param->parameterId() == 0)
+                qWarning() << "UDP field not registered, its samples are dropped:" << param->label();
+    }
+
+    // fields follow the parameters in the order of the layouts, an unregistered one keeps the
+    // invalid serie 0 which the buffer and the archive ignore
+    int j = 0;
+    for(UdpFrameLayout &layout : mLayouts) {
+        layout.serieIndexes.resize(layout.fields.size());
+        for(int k = 0; k < layout.fields.size(); k++)
+            layout.serieIndexes[k] = mListParam.at(j++)->parameterId();
+    }
+}
+
+void UdpDataSource::unregisterParameters()
+{
+    QVector<quint32> parameterIds;
+    for(const UdpFrameLayout &layout : mLayouts)
+        parameterIds += layout.serieIndexes;
+    DataSource::unregisterParameters(parameterIds);
+}
+
+void UdpDataSource::updateData()
+{
+    for(UdpSocket *socket : mSockets)
+        receive(socket);
+}
+
+void UdpDataSource::decode(UdpSocket *socket, const uchar *frame, int size, QTBTimestamp receiveTime)
+{
+    const UdpFrameLayout &layout = mLayouts.at(socket->layout);
+    QTBTimestamp timestamp;
+    if(!layout.decode(frame, size, receiveTime, &timestamp, mValues.data())) {
+        socket->shortFrames.storeRelease(socket->shortFrames.loadAcquire() + 1);
+        return;
+    }
+
+    const quint32 count = quint32(layout.fields.size());
+    const quint32 accepted = updateSamples(timestamp, layout.serieIndexes.constData(), mValues.constData(), count);
+    if(accepted < count)
+        socket->queueDrops.storeRelease(socket->queueDrops.loadAcquire() + (count - accepted));
+}
+
+#ifdef Q_OS_LINUX
+
+void UdpDataSource::receive(UdpSocket *socket)
+{
+    mmsghdr messages[UDP_BATCH_FRAMES];
+    iovec vectors[UDP_BATCH_FRAMES];
+    uchar *frames = reinterpret_cast<uchar*>(mFrames.data());
+    char *controls = mControls.data();
+
+    // the socket is drained batch by batch, a short batch means it is empty
+    int received;
+    do {
+        memset(messages, 0, sizeof(messages));
+        for(int i = 0; i < UDP_BATCH_FRAMES; i++) {
+            vectors[i].iov_base = frames + i * UDP_FRAME_MAX_SIZE;
+            vectors[i].iov_len = UDP_FRAME_MAX_SIZE;
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_control = controls + i * UDP_CONTROL_SIZE;
+            messages[i].msg_hdr.msg_controllen = UDP_CONTROL_SIZE;
+        }
+
+        received = recvmmsg(socket->fd, messages, UDP_BATCH_FRAMES, MSG_DONTWAIT, nullptr);
+        if(received <= 0)
+            return;
+
+        const QTBTimestamp now = timestampNow();
+        for(int i = 0; i < received; i++) {
+            QTBTimestamp receiveTime = now;
+            msghdr *header = &messages[i].msg_hdr;
+            for(cmsghdr *control = CMSG_FIRSTHDR(header); control; control = CMSG_NXTHDR(header, control)) {
+                if(control->cmsg_level != SOL_SOCKET)
+                    continue;
+                if(control->cmsg_type == SCM_TIMESTAMPNS) {
+                    timespec time;
+                    memcpy(&time, CMSG_DATA(control), sizeof(time));
+                    receiveTime = QTBTimestamp(time.tv_sec) * TIMESTAMP_NS_PER_SEC + time.tv_nsec;
+                } else if(control->cmsg_type == SO_RXQ_OVFL) {
+                    // drops of the socket since it was opened
+                    quint32 drops;
+                    memcpy(&drops, CMSG_DATA(control), sizeof(drops));
+                    socket->kernelDrops.storeRelease(drops);
+                }
+            }
+
+            decode(socket, frames + i * UDP_FRAME_MAX_SIZE, int(messages[i].msg_len), receiveTime);
+        }
+        socket->frames.storeRelease(socket->frames.loadAcquire() + quint64(received));
+    } while(received == UDP_BATCH_FRAMES);
+}
+
+#else
+
+void UdpDataSource::receive(UdpSocket *socket)
+{
+    // one frame per call where recvmmsg is not available
+    uchar *frame = reinterpret_cast<uchar*>(mFrames.data());
+    const QTBTimestamp now = timestampNow();
+    forever {
+        const ssize_t size = recv(socket->fd, frame, UDP_FRAME_MAX_SIZE, MSG_DONTWAIT);
+        if(size < 0)
+            return;
+        decode(socket, frame, int(size), now);
+        socket->frames.storeRelease(socket->frames.loadAcquire() + 1);
+    }
+}
+
+#endif
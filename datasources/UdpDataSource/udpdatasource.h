@@ -0,0 +1,100 @@
+#ifndef UDPDATASOURCE_H
+#define UDPDATASOURCE_H
+
+#include <QtPlugin>
+#include <QThread>
+#include <QTimer>
+#include <QAtomicInteger>
+#include "data/data_source_interface.h"
+#include "udpframelayout.h"
+
+#define UDP_SETTINGS_FILE "udpdatasource.ini"
+#define UDP_POLL_PERIOD_MS 1
+#define UDP_BATCH_FRAMES 64
+#define UDP_FRAME_MAX_SIZE 9216
+#define UDP_DEFAULT_RECEIVE_BUFFER (8 * 1024 * 1024)
+#define UDP_CONTROL_SIZE 128
+// samples queued per merge period, for 100k frames/s of up to 30 fields
+#define UDP_QUEUE_CAPACITY (1 << 20)
+
+struct UdpSocket
+{
+    UdpSocket() :
+        fd(-1),
+        port(0),
+        layout(0),
+        frames(0),
+        shortFrames(0),
+        kernelDrops(0),
+        queueDrops(0) {}
+
+    int fd;
+    QString group;
+    QString interfaceAddress;
+    quint16 port;
+    int layout;
+
+    // written by the receive thread only
+    QAtomicInteger<quint64> frames;
+    QAtomicInteger<quint64> shortFrames;    // smaller than the layout
+    QAtomicInteger<quint64> kernelDrops;    // socket buffer overflows
+    QAtomicInteger<quint64> queueDrops;     // samples rejected by the data source queue
+};
+
+/* Receives fixed layout binary frames over UDP, unicast or multicast.
+ * The settings are read from udpdatasource.ini next to the plugin:
+ *   [Sockets]      array of Group (multicast group or local address),
+ *                  Port, Interface (address of the multicast interface),
+ *                  Layout (name of the group describing the frames)
+ *   ReceiveBuffer  socket receive buffer in bytes
+ *   [<layout>]     BigEndian, TimeOffset (byte offset of a 64 bit time,
+ *                  -1 for the receive time), TimeUnit (s, ms, us, ns)
+ *                  and the Fields array of Label, Offset, Type
+ *                  (int8, uint8, int16, uint16, int32, uint32, float)
+ * Frames are read by batches (recvmmsg on Linux) on a separate thread and
+ * decoded in place into the sample queue. For a test on the loopback, use
+ * 127.0.0.1 as group. */
+class UdpDataSource: public DataSourceInterface
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID DataSourceInterface_iid FILE "udpdatasource.json")
+    Q_INTERFACES(DataSourceInterface)
+
+public:
+    UdpDataSource();
+    ~UdpDataSource() override;
+
+    bool startAcquisition() override;
+    bool stopAcquisition() override;
+
+    void loadSettings();
+    bool openSockets();
+    void closeSockets();
+    void registerParameters();
+    void unregisterParameters();
+
+    const QList<UdpSocket *> &sockets() const { return mSockets; }
+
+public slots:
+    void updateData();
+
+protected:
+    bool openSocket(UdpSocket *socket);
+    void receive(UdpSocket *socket);
+    void decode(UdpSocket *socket, const uchar *frame, int size, QTBTimestamp receiveTime);
+
+    QThread *mThread;
+    QTimer *mTimer;
+
+    int mReceiveBuffer;
+    QList<UdpSocket *> mSockets;
+    QVector<UdpFrameLayout> mLayouts;
+    QList<QSharedPointer<QTBParameter>> mListParam;
+
+    // receive buffers of a batch, and the values of one frame
+    QByteArray mFrames;
+    QByteArray mControls;
+    QVector<QTBDataValue> mValues;
+};
+
+#endif // UDPDATASOURCE_H
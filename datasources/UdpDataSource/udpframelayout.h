@@ -0,0 +1,109 @@
+#ifndef UDPFRAMELAYOUT_H
+#define UDPFRAMELAYOUT_H
+
+#include <QVector>
+#include <QString>
+#include <QtEndian>
+#include <cstring>
+#include "data/data_value.h"
+#include "data/data_timestamp.h"
+
+struct UdpField
+{
+    QString                     label;
+    quint32                     offset;
+    QTBDataValue::ValueType     type;
+};
+
+/* Decode table of a fixed layout binary frame: each field is read at its
+ * byte offset straight from the receive buffer, no copy of the frame.
+ * The timestamp is a 64 bit integer of the frame, or the receive time
+ * when timeOffset is negative. */
+class UdpFrameLayout
+{
+public:
+    UdpFrameLayout() :
+        bigEndian(true),
+        minimumSize(0),
+        timeOffset(-1),
+        timeScale(1) {}
+
+    void addField(const QString &label, quint32 offset, QTBDataValue::ValueType type)
+    {
+        UdpField field;
+        field.label = label;
+        field.offset = offset;
+        field.type = type;
+        fields.append(field);
+        minimumSize = qMax(minimumSize, int(offset) + QTBDataValue::valueSize(type));
+    }
+
+    void setTimeOffset(int offset, qint64 scale)
+    {
+        timeOffset = offset;
+        timeScale = scale;
+        if(offset >= 0)
+            minimumSize = qMax(minimumSize, offset + int(sizeof(qint64)));
+    }
+
+    // values holds one entry per field, false when the frame is too short
+    bool decode(const uchar *frame, int size, QTBTimestamp receiveTime,
+                QTBTimestamp *timestamp, QTBDataValue *values) const
+    {
+        if(size < minimumSize)
+            return false;
+
+        *timestamp = timeOffset < 0 ? receiveTime : read<qint64>(frame + timeOffset) * timeScale;
+
+        const int count = fields.size();
+        const UdpField *field = fields.constData();
+        for(int i = 0; i < count; i++, field++) {
+            const uchar *data = frame + field->offset;
+            switch(field->type) {
+            case QTBDataValue::TYPE_INT8: values[i] = QTBDataValue(qint8(*data)); break;
+            case QTBDataValue::TYPE_UINT8: values[i] = QTBDataValue(quint8(*data)); break;
+            case QTBDataValue::TYPE_INT16: values[i] = QTBDataValue(read<qint16>(data)); break;
+            case QTBDataValue::TYPE_UINT16: values[i] = QTBDataValue(read<quint16>(data)); break;
+            case QTBDataValue::TYPE_INT32: values[i] = QTBDataValue(read<qint32>(data)); break;
+            case QTBDataValue::TYPE_UINT32: values[i] = QTBDataValue(read<quint32>(data)); break;
+            case QTBDataValue::TYPE_FLOAT: {
+                const quint32 bits = read<quint32>(data);
+                float value;
+                memcpy(&value, &bits, sizeof(value));
+                values[i] = QTBDataValue(value);
+                break;
+            }
+            }
+        }
+        return true;
+    }
+
+    // names of the configuration files, float by default
+    static QTBDataValue::ValueType valueType(const QString &name)
+    {
+        if(name == QString("int8")) return QTBDataValue::TYPE_INT8;
+        if(name == QString("uint8")) return QTBDataValue::TYPE_UINT8;
+        if(name == QString("int16")) return QTBDataValue::TYPE_INT16;
+        if(name == QString("uint16")) return QTBDataValue::TYPE_UINT16;
+        if(name == QString("int32")) return QTBDataValue::TYPE_INT32;
+        if(name == QString("uint32")) return QTBDataValue::TYPE_UINT32;
+        return QTBDataValue::TYPE_FLOAT;
+    }
+
+    QString name;
+    bool bigEndian;
+    int minimumSize;
+    int timeOffset;
+    qint64 timeScale;
+    QVector<UdpField> fields;
+    QVector<quint32> serieIndexes;
+
+private:
+    template<typename T>
+    T read(const uchar *data) const
+    {
+        return bigEndian ? qFromBigEndian<T>(data) : qFromLittleEndian<T>(data);
+    }
+};
+
+#endif // UDPFRAMELAYOUT_H
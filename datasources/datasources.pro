@@ -2,4 +2,11 @@ TEMPLATE = subdirs
 CONFIG += ordered
 
 SUBDIRS = \
-    DemoDataSource 
+    DemoDataSource \
+    CsvDataSource \
+    LoadDataSource
+
+# sources written against the POSIX API
+unix: SUBDIRS += UdpDataSource ShmDataSource
+# epoll is Linux only
+linux: SUBDIRS += TcpDataSource
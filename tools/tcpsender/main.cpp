@@ -0,0 +1,236 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QtEndian>
+#include <QThread>
+#include <QVector>
+#include <QDebug>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include "data/data_timestamp.h"
+#include "data/data_value.h"
+
+#define TCPSENDER_HEADER_SIZE 16
+#define TCPSENDER_MAX_LABEL 255
+// steps of a client written at once, a slow reader doesn't grow the buffer
+#define TCPSENDER_MAX_STEPS 1000
+
+struct TcpClient
+{
+    int fd;
+    QVector<QByteArray> labels;
+    quint64 sent;
+};
+
+struct TcpSenderOptions
+{
+    QByteArray host;
+    quint16 port;
+    bool binary;
+    int clients;
+    int labels;
+    double rate;
+    qint64 duration;
+};
+
+/* One sample of the label, ramp of the integers for the even labels and a
+ * sine of period 1 s for the odd ones. */
+static void appendText(QByteArray &buffer, const QByteArray &label, int labelIndex, quint64 counter, QTBTimestamp timestamp, double rate)
+{
+    char line[TCPSENDER_MAX_LABEL + 64];
+    int size;
+    if(labelIndex & 1)
+        size = snprintf(line, sizeof(line), "%s %g %lld\n", label.constData(),
+                        sin(2.0 * M_PI * double(counter) / rate), static_cast<long long>(timestamp));
+    else
+        size = snprintf(line, sizeof(line), "%s %d %lld\n", label.constData(),
+                        int(counter & 0x7fffffff), static_cast<long long>(timestamp));
+    buffer.append(line, size);
+}
+
+static void appendMessage(QByteArray &buffer, const QByteArray &label, int labelIndex, quint64 counter, QTBTimestamp timestamp, double rate)
+{
+    uchar message[TCPSENDER_HEADER_SIZE + TCPSENDER_MAX_LABEL + 4];
+    const int labelSize = label.size();
+    quint32 raw;
+    quint8 type;
+    if(labelIndex & 1) {
+        const float sine = float(sin(2.0 * M_PI * double(counter) / rate));
+        memcpy(&raw, &sine, sizeof(raw));
+        type = QTBDataValue::TYPE_FLOAT;
+    } else {
+        raw = quint32(counter);
+        type = QTBDataValue::TYPE_UINT32;
+    }
+
+    qToLittleEndian<quint32>(quint32(TCPSENDER_HEADER_SIZE - 4 + labelSize + 4), message);
+    qToLittleEndian<qint64>(timestamp, message + 4);
+    message[12] = type;
+    message[13] = quint8(labelSize);
+    qToLittleEndian<quint16>(0, message + 14);
+    memcpy(message + TCPSENDER_HEADER_SIZE, label.constData(), size_t(labelSize));
+    qToLittleEndian<quint32>(raw, message + TCPSENDER_HEADER_SIZE + labelSize);
+    buffer.append(reinterpret_cast<const char*>(message), TCPSENDER_HEADER_SIZE + labelSize + 4);
+}
+
+static bool sendAll(int fd, const QByteArray &buffer)
+{
+    qint64 written = 0;
+    while(written < buffer.size()) {
+        const ssize_t result = ::send(fd, buffer.constData() + written, size_t(buffer.size() - written), MSG_NOSIGNAL);
+        if(result < 0) {
+            if(errno == EINTR)
+                continue;
+            return false;
+        }
+        written += result;
+    }
+    return true;
+}
+
+/* Runs the clients of one process, each on its own connection, every
+ * client sending the samples of its labels due by now in one write. */
+static int runProcess(int process, const TcpSenderOptions &options)
+{
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(options.port);
+    if(inet_pton(AF_INET, options.host.constData(), &address.sin_addr) != 1) {
+        qWarning() << "tcpsender: invalid address" << options.host;
+        return 1;
+    }
+
+    QVector<TcpClient> clients;
+    for(int i = 0; i < options.clients; i++) {
+        TcpClient client;
+        client.fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        client.sent = 0;
+        if(client.fd < 0 || ::connect(client.fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            qWarning() << "tcpsender: connect" << strerror(errno);
+            if(client.fd >= 0)
+                ::close(client.fd);
+            continue;
+        }
+        int enable = 1;
+        setsockopt(client.fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        for(int j = 0; j < options.labels; j++)
+            client.labels.append(QString("TCP.TEST.P%1.C%2.L%3").arg(process).arg(i).arg(j).toLatin1().left(TCPSENDER_MAX_LABEL));
+        clients.append(client);
+    }
+    if(clients.isEmpty())
+        return 1;
+
+    const QTBTimestamp start = timestampNow();
+    QTBTimestamp report = start + TIMESTAMP_NS_PER_SEC;
+    quint64 reported = 0;
+    QByteArray buffer;
+
+    while(!clients.isEmpty()) {
+        const QTBTimestamp now = timestampNow();
+        if(options.duration > 0 && now - start >= options.duration)
+            break;
+
+        quint64 sent = 0;
+        for(const TcpClient &client : clients)
+            sent += client.sent;
+        if(now >= report) {
+            qInfo() << "tcpsender:" << process << clients.size() << "clients," << (sent - reported) * quint64(options.labels) << "samples/s";
+            reported = sent;
+            report += TIMESTAMP_NS_PER_SEC;
+        }
+
+        // samples due by now, every label of a client at each step
+        const quint64 due = quint64(double(now - start) * options.rate / double(TIMESTAMP_NS_PER_SEC));
+        bool idle = true;
+        for(int i = clients.size() - 1; i >= 0; i--) {
+            TcpClient &client = clients[i];
+            if(due <= client.sent)
+                continue;
+            idle = false;
+
+            const quint64 last = qMin(due, client.sent + TCPSENDER_MAX_STEPS);
+            buffer.clear();
+            for(quint64 step = client.sent; step < last; step++) {
+                // each step is stamped at its due time, not at the write
+                const QTBTimestamp timestamp = start + QTBTimestamp(double(step) * double(TIMESTAMP_NS_PER_SEC) / options.rate);
+                for(int j = 0; j < client.labels.size(); j++) {
+                    if(options.binary)
+                        appendMessage(buffer, client.labels.at(j), j, step, timestamp, options.rate);
+                    else
+                        appendText(buffer, client.labels.at(j), j, step, timestamp, options.rate);
+                }
+            }
+            if(!sendAll(client.fd, buffer)) {
+                qWarning() << "tcpsender: client" << i << "closed," << strerror(errno);
+                ::close(client.fd);
+                clients.remove(i);
+                continue;
+            }
+            client.sent = last;
+        }
+        if(idle)
+            QThread::usleep(100);
+    }
+
+    for(const TcpClient &client : clients)
+        ::close(client.fd);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("tcpsender");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Sends test samples to the TCP data source from local client processes.");
+    parser.addHelpOption();
+    parser.addOption({{"a", "address"}, "Address of the data source.", "address", "127.0.0.1"});
+    parser.addOption({{"p", "port"}, "Port of the data source, its BinaryPort with --binary.", "port", "5001"});
+    parser.addOption({{"b", "binary"}, "Sends binary messages instead of text lines."});
+    parser.addOption({{"n", "processes"}, "Client processes.", "processes", "4"});
+    parser.addOption({{"c", "clients"}, "Connections per process.", "clients", "16"});
+    parser.addOption({{"l", "labels"}, "Labels per connection.", "labels", "8"});
+    parser.addOption({{"r", "rate"}, "Samples per second of each label.", "rate", "1000"});
+    parser.addOption({{"d", "duration"}, "Seconds to send, 0 to send until stopped.", "duration", "10"});
+    parser.process(app);
+
+    TcpSenderOptions options;
+    options.host = parser.value("address").toLatin1();
+    options.port = quint16(parser.value("port").toUInt());
+    options.binary = parser.isSet("binary");
+    options.clients = qMax(1, parser.value("clients").toInt());
+    options.labels = qMax(1, parser.value("labels").toInt());
+    options.rate = qMax(1.0, parser.value("rate").toDouble());
+    options.duration = parser.value("duration").toLongLong() * TIMESTAMP_NS_PER_SEC;
+    const int processes = qMax(1, parser.value("processes").toInt());
+
+    // every process is a separate producer, as the clients of the field are
+    QVector<pid_t> children;
+    for(int i = 1; i < processes; i++) {
+        const pid_t pid = fork();
+        if(pid == 0)
+            return runProcess(i, options);
+        if(pid < 0)
+            qWarning() << "tcpsender: fork" << strerror(errno);
+        else
+            children.append(pid);
+    }
+
+    int result = runProcess(0, options);
+    for(pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            result = 1;
+    }
+    return result;
+}
@@ -0,0 +1,25 @@
+QT       -= gui
+
+TARGET = tcpsender
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../../CuteBoard.pri)
+
+CONFIG(debug, debug|release) {
+    DESTDIR = $$PROJECT_ROOT_DIRECTORY/build/debug/tools
+}
+CONFIG(release, debug|release) {
+    DESTDIR = $$PROJECT_ROOT_DIRECTORY/build/release/tools
+}
+
+OBJECTS_DIR = $$DESTDIR/.obj/$$TARGET
+MOC_DIR = $$DESTDIR/.moc/$$TARGET
+
+INCLUDEPATH += $$PROJECT_ROOT_DIRECTORY
+
+SOURCES += \
+        main.cpp
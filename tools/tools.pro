@@ -0,0 +1,8 @@
+TEMPLATE = subdirs
+
+# senders for the tests of the network data sources on the loopback
+SUBDIRS = \
+    udpsender
+
+# the TCP data source is Linux only
+linux: SUBDIRS += tcpsender
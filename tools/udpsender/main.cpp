@@ -0,0 +1,140 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QtEndian>
+#include <QThread>
+#include <QDebug>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <math.h>
+#include "data/data_timestamp.h"
+
+#define UDPSENDER_BATCH_FRAMES 64
+#define UDPSENDER_FRAME_SIZE 20
+
+/* Sends the frames of the "Test" layout of the sample udpdatasource.ini,
+ * big endian:
+ *   0   qint64  time in ns since epoch
+ *   8   quint32 frame counter
+ *   12  float   sine of period 1 s
+ *   16  qint16  ramp
+ *   18  quint8  toggle, every 1000 frames
+ * Frames are sent by batches (sendmmsg on Linux) at the requested rate,
+ * the sender catches up when it falls behind and reports what it sent
+ * every second. */
+static void writeFrame(uchar *frame, quint32 counter, QTBTimestamp timestamp, double rate)
+{
+    const float sine = float(sin(2.0 * M_PI * double(counter) / rate));
+    quint32 sineBits;
+    memcpy(&sineBits, &sine, sizeof(sineBits));
+
+    qToBigEndian<qint64>(timestamp, frame);
+    qToBigEndian<quint32>(counter, frame + 8);
+    qToBigEndian<quint32>(sineBits, frame + 12);
+    qToBigEndian<qint16>(qint16(counter), frame + 16);
+    frame[18] = quint8((counter / 1000) & 1);
+    frame[19] = 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("udpsender");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Sends test frames to the UDP data source.");
+    parser.addHelpOption();
+    parser.addOption({{"a", "address"}, "Destination address or multicast group.", "address", "127.0.0.1"});
+    parser.addOption({{"p", "port"}, "Destination port.", "port", "5100"});
+    parser.addOption({{"r", "rate"}, "Frames per second.", "rate", "100000"});
+    parser.addOption({{"d", "duration"}, "Seconds to send, 0 to send until stopped.", "duration", "10"});
+    parser.process(app);
+
+    const QByteArray host = parser.value("address").toLatin1();
+    const quint16 port = quint16(parser.value("port").toUInt());
+    const double rate = qMax(1.0, parser.value("rate").toDouble());
+    const qint64 duration = parser.value("duration").toLongLong() * TIMESTAMP_NS_PER_SEC;
+
+    const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if(fd < 0) {
+        qWarning() << "udpsender: socket" << strerror(errno);
+        return 1;
+    }
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if(inet_pton(AF_INET, host.constData(), &address.sin_addr) != 1) {
+        qWarning() << "udpsender: invalid address" << host;
+        return 1;
+    }
+    if(::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        qWarning() << "udpsender: connect" << strerror(errno);
+        return 1;
+    }
+
+    uchar frames[UDPSENDER_BATCH_FRAMES][UDPSENDER_FRAME_SIZE];
+#ifdef Q_OS_LINUX
+    iovec vectors[UDPSENDER_BATCH_FRAMES];
+    mmsghdr messages[UDPSENDER_BATCH_FRAMES];
+    memset(messages, 0, sizeof(messages));
+    for(int i = 0; i < UDPSENDER_BATCH_FRAMES; i++) {
+        vectors[i].iov_base = frames[i];
+        vectors[i].iov_len = UDPSENDER_FRAME_SIZE;
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+#endif
+
+    const QTBTimestamp start = timestampNow();
+    QTBTimestamp report = start + TIMESTAMP_NS_PER_SEC;
+    quint32 counter = 0;
+    quint64 sent = 0;
+    quint64 reported = 0;
+    quint64 errors = 0;
+
+    forever {
+        const QTBTimestamp now = timestampNow();
+        if(duration > 0 && now - start >= duration)
+            break;
+
+        if(now >= report) {
+            qInfo() << "udpsender:" << sent - reported << "frames/s," << errors << "errors";
+            reported = sent;
+            report += TIMESTAMP_NS_PER_SEC;
+        }
+
+        // the frames due by now, by batches
+        const quint64 due = quint64(double(now - start) * rate / double(TIMESTAMP_NS_PER_SEC));
+        if(due <= sent) {
+            QThread::usleep(100);
+            continue;
+        }
+
+        const int count = int(qMin(due - sent, quint64(UDPSENDER_BATCH_FRAMES)));
+        for(int i = 0; i < count; i++)
+            writeFrame(frames[i], counter + quint32(i), now, rate);
+
+#ifdef Q_OS_LINUX
+        const int result = sendmmsg(fd, messages, unsigned(count), 0);
+        const int done = result < 0 ? 0 : result;
+#else
+        int done = 0;
+        while(done < count && ::send(fd, frames[done], UDPSENDER_FRAME_SIZE, 0) == UDPSENDER_FRAME_SIZE)
+            done++;
+#endif
+        if(done < count)
+            errors++;
+        // a frame that could not be sent is skipped, the pace is kept
+        counter += quint32(count);
+        sent += quint64(count);
+    }
+
+    qInfo() << "udpsender:" << sent << "frames sent," << errors << "errors";
+    ::close(fd);
+    return 0;
+}
@@ -3,7 +3,9 @@
 
 DashboardToolbar::DashboardToolbar(QWidget *parent) :
     QWidget(parent),
-    ui(new Ui::DashboardToolbar)
+    ui(new Ui::DashboardToolbar),
+    mReplayFirst(0),
+    mReplayStep(TIMESTAMP_NS_PER_MSEC)
 {
     ui->setupUi(this);
 
@@ -46,6 +48,34 @@ DashboardToolbar::DashboardToolbar(QWidget *parent) :
 
     connect(ui->comboBox, SIGNAL(currentIndexChanged(const QString)), this, SIGNAL(pageIndexChanged(const QString)));
 
+    QAction *actionPlay = new QAction(QIcon(":/icons8_circled_play_enabled_32px.png"), QString(""));
+    actionPlay->setShortcut(QKeySequence(tr("Ctrl+Space")));
+    actionPlay->setCheckable(true);
+    actionPlay->setChecked(false);
+    ui->playButton->setDefaultAction(actionPlay);
+    connect(actionPlay, SIGNAL(toggled(bool)),
+            this,SIGNAL(replayPlaying(bool)));
+
+    const QList<double> speeds = {0.1, 0.25, 0.5, 1, 2, 5, 10, 25, 50, 100};
+    for(double speed : speeds)
+        ui->speedComboBox->addItem(QString("x%1").arg(speed), speed);
+    ui->speedComboBox->setCurrentIndex(speeds.indexOf(1));
+    connect(ui->speedComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            [this](int index) {
+        emit replaySpeed(ui->speedComboBox->itemData(index).toDouble());
+    });
+
+    // a drag only seeks once released, the buffer is reloaded on each seek
+    connect(ui->replaySlider, &QSlider::sliderReleased,
+            [this]() {
+        emit replaySeek(mReplayFirst + ui->replaySlider->value() * mReplayStep);
+    });
+    connect(ui->replaySlider, &QSlider::valueChanged,
+            [this](int value) {
+        if(!ui->replaySlider->isSliderDown())
+            emit replaySeek(mReplayFirst + value * mReplayStep);
+    });
+
     ui->comboBox->setCurrentIndex(-1);    
 }
 
@@ -92,6 +122,39 @@ void DashboardToolbar::setMode(DashboardToolbar::DashboardMode mode)
     }
 }
 
+void DashboardToolbar::setReplayRange(QTBTimestamp first, QTBTimestamp last)
+{
+    const QSignalBlocker blocker(ui->replaySlider);
+    mReplayFirst = first;
+    mReplayStep = qMax(TIMESTAMP_NS_PER_MSEC, (last - first) / INT_MAX + 1);
+    ui->replaySlider->setRange(0, int((last - first) / mReplayStep));
+    ui->replaySlider->setSingleStep(int(qMax(Q_INT64_C(1), TIMESTAMP_NS_PER_SEC / 10 / mReplayStep)));
+    ui->replaySlider->setPageStep(int(qMax(Q_INT64_C(1), 10 * TIMESTAMP_NS_PER_SEC / mReplayStep)));
+    ui->replayBeginLabel->setText(replayTimeString(first));
+    ui->replayEndLabel->setText(replayTimeString(last));
+}
+
+void DashboardToolbar::setReplayPlaying(bool playing)
+{
+    const QSignalBlocker blocker(ui->playButton->defaultAction());
+    ui->playButton->defaultAction()->setChecked(playing);
+}
+
+void DashboardToolbar::setReplayPosition(QTBTimestamp position)
+{
+    if(ui->replaySlider->isSliderDown())
+        return;
+
+    const QSignalBlocker blocker(ui->replaySlider);
+    ui->replaySlider->setValue(int((position - mReplayFirst) / mReplayStep));
+}
+
+QString DashboardToolbar::replayTimeString(QTBTimestamp timestamp) const
+{
+    QDateTime time = QDateTime::fromMSecsSinceEpoch(timestamp / TIMESTAMP_NS_PER_MSEC, Qt::UTC);
+    return time.toString("yyyy-MM-dd HH:mm:ss.zzz");
+}
+
 void DashboardToolbar::setEdition(bool edition)
 {
     ui->pagesNavWidget->setVisible(!edition);
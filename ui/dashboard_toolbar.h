@@ -5,6 +5,7 @@
 #include <QAction>
 #include <QComboBox>
 #include "project/project.h"
+#include "data/data_timestamp.h"
 
 namespace Ui {
 class DashboardToolbar;
@@ -29,6 +30,10 @@ public:
     void setMode(DashboardMode mode);
     void setEdition(bool edition);
 
+    void setReplayRange(QTBTimestamp first, QTBTimestamp last);
+    void setReplayPlaying(bool playing);
+    void setReplayPosition(QTBTimestamp position);
+
 public slots:
     void updateList();
     void pageSelected();
@@ -37,10 +42,18 @@ signals:
     void pageIndexChanged(const QString pageName);
     void fullScreen(bool fullScreen);
     void pagePaused(bool pause);
+    void replayPlaying(bool playing);
+    void replaySeek(QTBTimestamp position);
+    void replaySpeed(double speed);
 
 private:
+    QString replayTimeString(QTBTimestamp timestamp) const;
+
     Ui::DashboardToolbar *ui;
     QSharedPointer<QTBProject> mProject;
+    QTBTimestamp mReplayFirst;
+    // slider unit, keeps the range of a long archive within an int
+    QTBTimestamp mReplayStep;
 };
 
 #endif // LIVETOOLBARWIDGET_H
@@ -45,6 +45,13 @@ DashboardWidget::DashboardWidget(QWidget *parent) :
     connect(mBoard->project().data(), &QTBProject::pageLoaded, ui->pagePicker, &PagePickerWidget::pageSelected);
 
     connect(mBoard, &QTBoard::timeUpdate, this, &DashboardWidget::updateTime);
+
+    QTBDataReplay *replay = mBoard->dataManager()->replay();
+    if(replay) {
+        connect(ui->liveToolbar, &DashboardToolbar::replayPlaying, replay, &QTBDataReplay::setPlaying);
+        connect(ui->liveToolbar, &DashboardToolbar::replaySeek, replay, &QTBDataReplay::seek);
+        connect(ui->liveToolbar, &DashboardToolbar::replaySpeed, replay, &QTBDataReplay::setSpeed);
+    }
 }
 
 DashboardWidget::~DashboardWidget()
@@ -68,6 +75,12 @@ void DashboardWidget::updateTime(const QDateTime& time)
         QString timeString = time.toString("HH:mm:ss.zzz ") + time.timeZone().displayName(QTimeZone::DaylightTime,QTimeZone::OffsetName);
         ui->liveToolbar->setTime(timeString);
     }
+
+    QTBDataManager *dataManager = mBoard->dataManager().data();
+    if(dataManager->replaying()) {
+        ui->liveToolbar->setReplayPosition(timestampFromMSecs(time.toMSecsSinceEpoch()));
+        ui->liveToolbar->setReplayPlaying(dataManager->replay()->playing());
+    }
 }
 
 QTBoard *DashboardWidget::board() const
@@ -77,6 +90,17 @@ QTBoard *DashboardWidget::board() const
 
 void DashboardWidget::setMode(DashboardToolbar::DashboardMode mode)
 {
+    QTBDataManager *dataManager = mBoard->dataManager().data();
+    if(mode == DashboardToolbar::dmReplay) {
+        dataManager->startReplay();
+        if(dataManager->replay()) {
+            ui->liveToolbar->setReplayRange(dataManager->replay()->first(), dataManager->replay()->last());
+            ui->liveToolbar->setReplayPosition(dataManager->replay()->position());
+            ui->liveToolbar->setReplayPlaying(false);
+        }
+    } else {
+        dataManager->stopReplay();
+    }
     ui->liveToolbar->setMode(mode);
 }
 
@@ -150,7 +150,8 @@ void MainWindow::projectSelected()
 {
     mLiveAction->setEnabled(true);
     mDesignAction->setEnabled(true);
-//    mReplayAction->setEnabled(true);
+    // playback needs an archive to read from
+    mReplayAction->setEnabled(ui->dashboardWidget->board()->dataManager()->archive() != nullptr);
 }
 
 void MainWindow::init()
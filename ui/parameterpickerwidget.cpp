@@ -1,5 +1,9 @@
 #include "parameterpickerwidget.h"
 #include "ui_parameterpickerwidget.h"
+#include <QFileDialog>
+#include <QInputDialog>
+#include <QMessageBox>
+#include <QProgressDialog>
 
 ParameterPickerWidget::ParameterPickerWidget(QWidget *parent) :
     QWidget(parent),
@@ -10,6 +14,7 @@ ParameterPickerWidget::ParameterPickerWidget(QWidget *parent) :
     ui->setupUi(this);
     connect(ui->lineEdit, SIGNAL(textChanged(QString)), this, SLOT(searchString(QString)));
     connect(ui->toListToolButton, SIGNAL(toggled(bool)), this, SLOT(changeListDisplay()));
+    connect(ui->exportToolButton, SIGNAL(clicked()), this, SLOT(exportParameters()));
 }
 
 ParameterPickerWidget::~ParameterPickerWidget()
@@ -21,11 +26,8 @@ void ParameterPickerWidget::updateParameterList()
 {
     if(!mDataManager.isNull()) {
         ui->listWidget->clear();
-        QHash<QString, QString> parameterSourceNames = mDataManager->parameterSourceNames();
-
-        QHash<QString, QString>::iterator i;
-        for (i = parameterSourceNames.begin(); i != parameterSourceNames.end(); ++i) {
-            QString sourceName = i.value();
+        // the category of a source is looked up once for all its parameters
+        for (const QString &sourceName : mDataManager->parameterSources()) {
             QTreeWidgetItem *parentItem = nullptr;
 
             if(mTreeMode) {
@@ -64,14 +66,18 @@ void ParameterPickerWidget::updateParameterList()
             }
             }
 
-            QTreeWidgetItem *item = new QTreeWidgetItem();
-            item->setText(0,i.key());
-            item->setData(0,Qt::UserRole, i.key());
+            QList<QTreeWidgetItem *> items;
+            for (const QString &label : mDataManager->sourceLabels(sourceName)) {
+                QTreeWidgetItem *item = new QTreeWidgetItem();
+                item->setText(0,label);
+                item->setData(0,Qt::UserRole, label);
+                items.append(item);
+            }
 
             if(parentItem) {
-                parentItem->addChild(item);
+                parentItem->addChildren(items);
             } else {
-                ui->listWidget->addTopLevelItem(item);
+                ui->listWidget->addTopLevelItems(items);
             }
 
         }
@@ -86,6 +92,68 @@ void ParameterPickerWidget::changeListDisplay()
     updateParameterList();
 }
 
+void ParameterPickerWidget::exportParameters()
+{
+    if(mDataManager.isNull())
+        return;
+
+    // a selected category exports all its parameters
+    QStringList labels;
+    for(QTreeWidgetItem *item : ui->listWidget->selectedItems())
+        selectedLabels(item, labels);
+    labels.removeDuplicates();
+    if(labels.isEmpty())
+        return;
+
+    bool ok = false;
+    int minutes = QInputDialog::getInt(this, "Export", "Last minutes to export", 10, 1, 7 * 24 * 60, 1, &ok);
+    if(!ok)
+        return;
+
+    QString csvFilter("CSV (*.csv)");
+    QString binaryFilter("Binary (*.qtbx)");
+    QString selectedFilter;
+    QString fileName = QFileDialog::getSaveFileName(this, "Export", QString(),
+                                                    csvFilter + QString(";;") + binaryFilter, &selectedFilter);
+    if(fileName.isEmpty())
+        return;
+
+    // the archive reaches further back than the buffer
+    QTBDataExportSettings settings;
+    settings.fileName = fileName;
+    settings.format = selectedFilter == binaryFilter ? QTBDataExportSettings::efBinary : QTBDataExportSettings::efCsv;
+    settings.source = mDataManager->archive() ? QTBDataExportSettings::esArchive : QTBDataExportSettings::esBuffer;
+    settings.labels = labels;
+    settings.end = timestampNow();
+    settings.begin = settings.end - qint64(minutes) * 60 * TIMESTAMP_NS_PER_SEC;
+
+    QProgressDialog *progressDialog = new QProgressDialog("Exporting " + fileName, "Cancel", 0, 100, this);
+    progressDialog->setAttribute(Qt::WA_DeleteOnClose);
+    progressDialog->setMinimumDuration(500);
+
+    QTBDataExport *dataExport = mDataManager->exportData(settings);
+    connect(dataExport, SIGNAL(progress(int)), progressDialog, SLOT(setValue(int)));
+    connect(progressDialog, SIGNAL(canceled()), dataExport, SLOT(cancel()), Qt::DirectConnection);
+    connect(dataExport, &QTBDataExport::finished, progressDialog, [progressDialog](bool success, const QString &message) {
+        // closing emits canceled, the export is done with
+        progressDialog->disconnect(SIGNAL(canceled()));
+        progressDialog->close();
+        if(!success)
+            QMessageBox::warning(nullptr, "Export", message);
+    });
+    dataExport->start();
+}
+
+void ParameterPickerWidget::selectedLabels(QTreeWidgetItem *item, QStringList &labels) const
+{
+    if(item->childCount() == 0) {
+        labels.append(item->data(0, Qt::UserRole).toString());
+    } else {
+        for (int k=0;k<item->childCount();k++)
+            selectedLabels(item->child(k), labels);
+    }
+}
+
 void ParameterPickerWidget::setDataManager(const QSharedPointer<QTBDataManager> &dataManager)
 {
     mDataManager = dataManager;
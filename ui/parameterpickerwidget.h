@@ -22,8 +22,10 @@ public slots:
     void updateParameterList();
 private slots:
     void changeListDisplay();
+    void exportParameters();
     void searchString(const QString& str);
     void searchAndHide(const QString& str, QTreeWidgetItem *item);
+    void selectedLabels(QTreeWidgetItem *item, QStringList &labels) const;
 
 private:
     Ui::ParameterPickerWidget *ui;
@@ -99,6 +99,12 @@ void QTBSettingsDialog::updateStatus()
 
             QTableWidgetItem *itemStatus = new QTableWidgetItem(QMetaEnum::fromType<DataSource::DataSourceStatus>().valueToKey(Iter.value()->status()));
             ui->tableWidget->setItem(0,1,itemStatus);
+
+            QTableWidgetItem *itemDropped = new QTableWidgetItem(QString::number(Iter.value()->droppedSamples()));
+            ui->tableWidget->setItem(0,2,itemDropped);
+
+            QTableWidgetItem *itemLate = new QTableWidgetItem(QString::number(Iter.value()->lateSamples()));
+            ui->tableWidget->setItem(0,3,itemLate);
         }
 
         ui->tableWidget->resizeColumnToContents(0);